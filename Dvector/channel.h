@@ -0,0 +1,323 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+#include "dvector.h"
+
+/**
+ *  single-threaded executor:
+ *  		keeps coroutines which are ready to continue
+ *  		and resumes them in FIFO order from run()
+ */
+class Executor {
+public:
+	class Task;
+
+	/**
+	 * @brief	queues coroutine to be resumed by run()
+	 * 			does not allocate unless the ready queue has to grow
+	 * @param 	handle		suspended coroutine
+	 */
+	void schedule(std::coroutine_handle<> handle) {
+		_ready.push_back(handle);
+	}
+
+	/**
+	 * @brief	starts Task on this executor
+	 * 			Task does not run until run() is called
+	 * @param 	task
+	 */
+	inline void spawn(Task task);
+
+	/**
+	 * @brief	resumes the first ready coroutine
+	 * @return 	false if there was nothing to resume, true otherwise
+	 * @throw	exception which escaped from the body of the resumed Task,
+	 * 			the Task is finished and the other coroutines stay queued
+	 */
+	bool run_one() {
+		if (_ready.empty())
+			return false;
+		std::coroutine_handle<> handle = _ready.front();
+		_ready.pop_front();
+		handle.resume();
+		if (_error)
+			std::rethrow_exception(std::exchange(_error, nullptr));
+		return true;
+	}
+
+	/**
+	 * @brief	resumes ready coroutines until none is left
+	 * 			coroutines scheduled while running are resumed as well
+	 * @throw	exception which escaped from the body of a Task (see run_one)
+	 */
+	void run() {
+		while (run_one()) {}
+	}
+
+private:
+	DVector<std::coroutine_handle<>> _ready;
+	std::exception_ptr _error;          // thrown by the Task being resumed
+};
+
+/**
+ *  fire-and-forget coroutine started by Executor::spawn
+ *  		frame is destroyed as soon as the coroutine finishes,
+ *  		exception escaping from its body is rethrown by Executor::run_one
+ */
+class Executor::Task {
+public:
+	struct promise_type {
+		Task get_return_object() {
+			return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() noexcept {}
+		void unhandled_exception() noexcept { _executor->_error = std::current_exception(); }
+
+		Executor* _executor = nullptr;      // set by Executor::spawn
+	};
+
+	Task(Task&& o) noexcept
+			: _handle(std::exchange(o._handle, nullptr)) {}
+
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+
+	/**
+	 * @brief	destroys coroutine which has never been spawned
+	 */
+	~Task() {
+		if (_handle)
+			_handle.destroy();
+	}
+
+private:
+	friend class Executor;
+	std::coroutine_handle<promise_type> _handle;
+
+	explicit Task(std::coroutine_handle<promise_type> handle)
+			: _handle(handle) {}
+};
+
+void Executor::spawn(Task task) {
+	task._handle.promise()._executor = this;
+	schedule(std::exchange(task._handle, nullptr));
+}
+
+/**
+ *  bounded channel between coroutines running on one Executor:
+ *  		values are buffered in DVector which is reserved up front,
+ *  		senders suspend while the buffer is full and receivers while it is empty
+ *  		suspended coroutines are queued in intrusive lists made of their
+ *  		awaiters (which live in the coroutine frames) - no operation allocates
+ */
+template <typename T>
+class Channel {
+	/**
+	 * @brief	FIFO list of suspended awaiters linked through their _next member
+	 */
+	template <typename Awaiter>
+	struct WaitList {
+		Awaiter* head = nullptr;
+		Awaiter* tail = nullptr;
+
+		bool empty() const noexcept {
+			return !head;
+		}
+
+		void push(Awaiter* a) noexcept {
+			a->_next = nullptr;
+			if (tail)
+				tail->_next = a;
+			else
+				head = a;
+			tail = a;
+		}
+
+		Awaiter* pop() noexcept {
+			Awaiter* a = head;
+			head = a->_next;
+			if (!head)
+				tail = nullptr;
+			return a;
+		}
+	};
+
+public:
+	class SendAwaiter;
+	class RecvAwaiter;
+
+	/**
+	 * @brief	constructs channel
+	 * 			bound of 0 makes every send wait for its receiver
+	 * @param 	executor	executor resuming suspended senders and receivers
+	 * @param 	bound		maximal number of buffered values
+	 */
+	Channel(Executor& executor, std::size_t bound)
+			: _executor(executor),
+			  _bound(bound) {
+		_buffer.reserve(bound);
+	}
+
+	Channel(const Channel&) = delete;
+	Channel& operator=(const Channel&) = delete;
+
+	/**
+	 * @brief	sends value, usage: bool sent = co_await ch.send(v);
+	 * 			suspends while the buffer is full
+	 * @param 	value
+	 * @return 	awaiter yielding false if the channel was closed, true otherwise
+	 */
+	SendAwaiter send(T value) {
+		return SendAwaiter(*this, std::move(value));
+	}
+
+	/**
+	 * @brief	receives value, usage: std::optional<T> v = co_await ch.recv();
+	 * 			suspends while the buffer is empty
+	 * @return 	awaiter yielding std::nullopt once the channel is closed and drained
+	 */
+	RecvAwaiter recv() {
+		return RecvAwaiter(*this);
+	}
+
+	/**
+	 * @brief	closes channel
+	 * 			waiting senders fail, waiting receivers get std::nullopt,
+	 * 			values already buffered can still be received
+	 */
+	void close() {
+		_closed = true;
+		while (!_senders.empty()) {
+			SendAwaiter* s = _senders.pop();
+			s->_sent = false;
+			_executor.schedule(s->_handle);
+		}
+		while (!_receivers.empty())
+			_executor.schedule(_receivers.pop()->_handle);
+	}
+
+	/**
+	 * @return	true if close() has been called
+	 */
+	bool closed() const noexcept {
+		return _closed;
+	}
+
+	/**
+	 * @return	number of buffered values
+	 */
+	std::size_t size() const noexcept {
+		return _buffer.size();
+	}
+
+	/**
+	 * @return 	maximal number of buffered values
+	 */
+	std::size_t bound() const noexcept {
+		return _bound;
+	}
+
+	class SendAwaiter {
+	public:
+		bool await_ready() {
+			Channel& ch = *_channel;
+			if (ch._closed) {
+				_sent = false;
+				return true;
+			}
+			if (!ch._receivers.empty()) {   // buffer is empty, hand over directly
+				RecvAwaiter* r = ch._receivers.pop();
+				r->_value.emplace(std::move(_value));
+				ch._executor.schedule(r->_handle);
+				return true;
+			}
+			if (ch._buffer.size() < ch._bound) {
+				ch._buffer.push_back(std::move(_value));
+				return true;
+			}
+			return false;
+		}
+
+		void await_suspend(std::coroutine_handle<> handle) noexcept {
+			_handle = handle;
+			_channel->_senders.push(this);
+		}
+
+		bool await_resume() const noexcept {
+			return _sent;
+		}
+
+	private:
+		friend class Channel;
+		friend struct WaitList<SendAwaiter>;
+
+		Channel* _channel;
+		T _value;
+		bool _sent = true;
+		std::coroutine_handle<> _handle;
+		SendAwaiter* _next = nullptr;
+
+		SendAwaiter(Channel& channel, T&& value)
+				: _channel(&channel),
+				  _value(std::move(value)) {}
+	};
+
+	class RecvAwaiter {
+	public:
+		bool await_ready() {
+			Channel& ch = *_channel;
+			if (!ch._buffer.empty()) {
+				_value.emplace(std::move(ch._buffer.front()));
+				ch._buffer.pop_front();
+				if (!ch._senders.empty()) {     // refill the slot just freed
+					SendAwaiter* s = ch._senders.pop();
+					ch._buffer.push_back(std::move(s->_value));
+					ch._executor.schedule(s->_handle);
+				}
+				return true;
+			}
+			if (!ch._senders.empty()) {         // unbuffered channel
+				SendAwaiter* s = ch._senders.pop();
+				_value.emplace(std::move(s->_value));
+				ch._executor.schedule(s->_handle);
+				return true;
+			}
+			return ch._closed;
+		}
+
+		void await_suspend(std::coroutine_handle<> handle) noexcept {
+			_handle = handle;
+			_channel->_receivers.push(this);
+		}
+
+		std::optional<T> await_resume() {
+			return std::move(_value);
+		}
+
+	private:
+		friend class Channel;
+		friend struct WaitList<RecvAwaiter>;
+
+		Channel* _channel;
+		std::optional<T> _value;
+		std::coroutine_handle<> _handle;
+		RecvAwaiter* _next = nullptr;
+
+		explicit RecvAwaiter(Channel& channel)
+				: _channel(&channel) {}
+	};
+
+private:
+	Executor& _executor;
+	DVector<T> _buffer;
+	std::size_t _bound;
+	bool _closed = false;
+	WaitList<SendAwaiter> _senders;
+	WaitList<RecvAwaiter> _receivers;
+}; // Channel
@@ -1,4 +1,10 @@
 #include "dvector.h"
+#include "channel.h"
+#include "soadvector.h"
+#include "mapped_dvector.h"
+#include "snapshot_dvector.h"
+#include <thread>
+#include <filesystem>
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
 #include <deque>
@@ -448,3 +454,471 @@ TEST_CASE( "grow uses allocator and throws" ) {
                        const std::bad_alloc & );
     REQUIRE( alloc.failedAlloc == 1 );
 }
+
+static_assert( sizeof( DVector< int > ) == 3 * sizeof( void * ), "DVector header is not compact" );
+
+TEST_CASE( "wrap around and grow" ) {
+    AllocatorRAII< int > _;
+    TestVec< int > vi;
+
+    for ( int i = 0; i < 4; ++i ) {
+        vi.push_back( i );
+        vi.push_front( -i - 1 );
+    }
+    REQUIRE( vi.size() == vi.capacity() ); // full ring, begin must still differ from end
+    REQUIRE( vi.begin() != vi.end() );
+    REQUIRE( std::next( vi.begin(), vi.size() ) == vi.end() );
+    for ( int i = 0; i < 8; ++i ) {
+        REQUIRE( vi[ i ] == i - 4 );
+    }
+
+    vi.push_front( -5 );
+    REQUIRE( _.state().alloc == 2 );
+    REQUIRE( vi.size() == 9 );
+    for ( int i = 0; i < 9; ++i ) {
+        REQUIRE( vi[ i ] == i - 5 );
+        REQUIRE( *slownext( vi.begin(), i ) == i - 5 );
+    }
+}
+
+TEST_CASE( "resize and clear" ) {
+    AllocatorRAII< int > _;
+    TestVec< int > vi = { 1, 2, 3 };
+    vi.push_front( 0 );
+
+    vi.resize( 6 );
+    REQUIRE( vi.size() == 6 );
+    REQUIRE( vi[ 0 ] == 0 );
+    REQUIRE( vi[ 3 ] == 3 );
+    REQUIRE( vi[ 4 ] == 0 );
+    REQUIRE( vi[ 5 ] == 0 );
+
+    vi.resize( 2 );
+    REQUIRE( vi.size() == 2 );
+    REQUIRE( vi.back() == 1 );
+
+    vi.clear();
+    REQUIRE( vi.empty() );
+    REQUIRE( vi.begin() == vi.end() );
+    REQUIRE( vi.capacity() >= 6 );
+}
+
+Executor::Task produce( Channel< int > &ch, int count, std::size_t &maxBuffered ) {
+    for ( int i = 0; i < count; ++i ) {
+        bool sent = co_await ch.send( i );
+        REQUIRE( sent );
+        maxBuffered = std::max( maxBuffered, ch.size() );
+    }
+    ch.close();
+}
+
+Executor::Task consume( Channel< int > &ch, std::vector< int > &out ) {
+    while ( auto v = co_await ch.recv() ) {
+        out.push_back( *v );
+    }
+}
+
+TEST_CASE( "channel" ) {
+    Executor ex;
+    std::vector< int > out;
+    std::size_t maxBuffered = 0;
+
+    SECTION( "bounded" ) {
+        Channel< int > ch( ex, 2 );
+        ex.spawn( consume( ch, out ) );
+        ex.spawn( produce( ch, 10, maxBuffered ) );
+        ex.run();
+        REQUIRE( maxBuffered <= 2 );
+    }
+    SECTION( "unbuffered" ) {
+        Channel< int > ch( ex, 0 );
+        ex.spawn( produce( ch, 10, maxBuffered ) );
+        ex.spawn( consume( ch, out ) );
+        ex.run();
+        REQUIRE( maxBuffered == 0 );
+    }
+    REQUIRE( out.size() == 10 );
+    for ( int i = 0; i < 10; ++i ) {
+        REQUIRE( out[ i ] == i );
+    }
+}
+
+Executor::Task sendAfterClose( Channel< NotCopyable > &ch, bool &sent ) {
+    sent = co_await ch.send( NotCopyable() );
+}
+
+TEST_CASE( "channel close wakes senders" ) {
+    Executor ex;
+    Channel< NotCopyable > ch( ex, 0 );
+    bool sent = true;
+    ex.spawn( sendAfterClose( ch, sent ) );
+    ex.run();
+    REQUIRE( sent ); // still suspended
+    ch.close();
+    ex.run();
+    REQUIRE_FALSE( sent );
+}
+
+Executor::Task failAfterRecv( Channel< int > &ch ) {
+    auto v = co_await ch.recv();
+    if ( v ) {
+        throw std::runtime_error( "task failed" );
+    }
+}
+
+TEST_CASE( "task exception is rethrown by run" ) {
+    Executor ex;
+    Channel< int > ch( ex, 1 );
+    std::vector< int > out;
+    std::size_t maxBuffered = 0;
+    ex.spawn( failAfterRecv( ch ) );
+    ex.spawn( consume( ch, out ) );
+    ex.spawn( produce( ch, 3, maxBuffered ) );
+    REQUIRE_THROWS_AS( ex.run(), const std::runtime_error & );
+    ex.run();               // the other coroutines stay queued
+    REQUIRE( out.size() == 2 );
+    REQUIRE( ch.closed() );
+}
+
+TEST_CASE( "sorted search across wrap" ) {
+    AllocatorRAII< int > _;
+    TestVec< int > vi;
+
+    for ( int i = 0; i < 6; ++i ) {
+        vi.push_back( 2 * i );
+    }
+    for ( int i = 0; i < 4; ++i ) {
+        vi.pop_front();
+        vi.push_back( 12 + 2 * i );
+    }
+    // ring wraps after the fourth element: 8 10 12 14 | 16 18
+    REQUIRE( *vi.lower_bound( 8 ) == 8 );
+    REQUIRE( *vi.lower_bound( 11 ) == 12 );
+    REQUIRE( *vi.lower_bound( 12 ) == 12 );
+    REQUIRE( *vi.upper_bound( 12 ) == 14 );
+    REQUIRE( vi.lower_bound( 19 ) == vi.end() );
+    REQUIRE( vi.lower_bound( 0 ) == vi.begin() );
+    for ( int k = 7; k <= 19; ++k ) {
+        auto std_it = std::lower_bound( vi.begin(), vi.end(), k );
+        REQUIRE( vi.lower_bound( k ) == std_it );
+        REQUIRE( vi.upper_bound( k ) == std::upper_bound( vi.begin(), vi.end(), k ) );
+    }
+
+    auto range = vi.equal_range( 16 );
+    REQUIRE( std::distance( range.first, range.second ) == 1 );
+    REQUIRE( *range.first == 16 );
+
+    const auto &cvi = vi;
+    REQUIRE( *cvi.lower_bound( 13, std::less<>() ) == 14 );
+
+    REQUIRE( vi.trim_front_until( 15 ) == 4 );
+    REQUIRE( vi.size() == 2 );
+    REQUIRE( vi.front() == 16 );
+    REQUIRE( vi.back() == 18 );
+    REQUIRE( vi.trim_front_until( 0 ) == 0 );
+    REQUIRE( vi.trim_front_until( 100 ) == 2 );
+    REQUIRE( vi.empty() );
+}
+
+TEST_CASE( "soa columns" ) {
+    SoaDVector< long, double, std::string > soa;
+    REQUIRE( soa.empty() );
+    REQUIRE_THROWS_AS( soa.front(), const std::runtime_error & );
+
+    for ( int i = 0; i < 6; ++i ) {
+        soa.push_back( long( i ), i * 0.5, std::to_string( i ) );
+    }
+    for ( int i = 1; i <= 4; ++i ) {
+        soa.push_front( long( -i ), -i * 0.5, std::to_string( -i ) );
+    }
+    REQUIRE( soa.size() == 10 );
+    REQUIRE( soa.capacity() >= 10 );
+    REQUIRE( std::get< 0 >( soa.front() ) == -4 );
+    REQUIRE( std::get< 2 >( soa.back() ) == "5" );
+    for ( int i = 0; i < 10; ++i ) {
+        REQUIRE( soa.get< 0 >( i ) == i - 4 );
+        REQUIRE( std::get< 1 >( soa[ i ] ) == ( i - 4 ) * 0.5 );
+        REQUIRE( soa.get< 2 >( i ) == std::to_string( i - 4 ) );
+    }
+
+    soa.pop_front();
+    soa.pop_back();
+    soa.push_back( 5L, 2.5, "5" );
+    auto timestamps = soa.column< 0 >();
+    REQUIRE( timestamps.first.size() + timestamps.second.size() == soa.size() );
+    long sum = 0;
+    for ( long t : timestamps.first ) sum += t;
+    for ( long t : timestamps.second ) sum += t;
+    REQUIRE( sum == -3 - 2 - 1 + 0 + 1 + 2 + 3 + 4 + 5 );
+
+    auto copy = soa;
+    REQUIRE( copy.size() == soa.size() );
+    REQUIRE( copy.get< 2 >( 0 ) == "-3" );
+    auto moved = std::move( copy );
+    REQUIRE( copy.empty() );
+    REQUIRE( moved.get< 2 >( 8 ) == "5" );
+    moved.clear();
+    REQUIRE( moved.empty() );
+}
+
+struct CopyThrows {
+    static int live;
+    static int copies_left;
+    int v;
+
+    CopyThrows( int v ) : v( v ) { ++live; }
+    CopyThrows( const CopyThrows &o ) : v( o.v ) {
+        if ( !copies_left-- ) {
+            throw std::runtime_error( "copy" );
+        }
+        ++live;
+    }
+    ~CopyThrows() { --live; }
+};
+
+int CopyThrows::live = 0;
+int CopyThrows::copies_left = 0;
+
+TEST_CASE( "soa reallocation keeps records if a column throws" ) {
+    {
+        SoaDVector< std::string, CopyThrows > soa;
+        CopyThrows::copies_left = 1000;
+        for ( int i = 0; i < 8; ++i ) {
+            soa.push_back( std::to_string( i ), CopyThrows( i ) );
+        }
+        REQUIRE( soa.size() == soa.capacity() );
+        REQUIRE( CopyThrows::live == 8 );
+
+        CopyThrows::copies_left = 3;        // fails while copying the column of CopyThrows
+        REQUIRE_THROWS_AS( soa.push_back( "8", CopyThrows( 8 ) ), const std::runtime_error & );
+        REQUIRE( CopyThrows::live == 8 );
+        REQUIRE( soa.size() == 8 );
+        for ( int i = 0; i < 8; ++i ) {
+            REQUIRE( soa.get< 0 >( i ) == std::to_string( i ) );
+            REQUIRE( soa.get< 1 >( i ).v == i );
+        }
+
+        CopyThrows::copies_left = 1000;
+        soa.push_back( "8", CopyThrows( 8 ) );
+        REQUIRE( soa.size() == 9 );
+        REQUIRE( soa.get< 1 >( 8 ).v == 8 );
+    }
+    REQUIRE( CopyThrows::live == 0 );
+}
+
+TEST_CASE( "bit queue" ) {
+    AllocatorRAII< std::uint64_t > _;
+    using Bits = TestVec< bool >;
+    static_assert( std::is_same< Bits::value_type, bool >::value, "" );
+    Bits bits;
+    std::deque< bool > ref;
+    auto check = [&] {
+        REQUIRE( bits.size() == ref.size() );
+        size_t pop = 0;
+        for ( size_t i = 0; i < ref.size(); ++i ) {
+            REQUIRE( bits[ i ] == ref[ i ] );
+            pop += ref[ i ];
+        }
+        REQUIRE( bits.popcount() == pop );
+        auto first = std::find( ref.begin(), ref.end(), true );
+        REQUIRE( bits.find_first_set() == ( first == ref.end() ? Bits::npos : size_t( first - ref.begin() ) ) );
+        REQUIRE( std::equal( bits.begin(), bits.end(), ref.begin(), ref.end() ) );
+    };
+
+    for ( int i = 0; i < 100; ++i ) {
+        bits.push_back( i % 3 == 0 );
+        ref.push_back( i % 3 == 0 );
+        bits.push_front( i % 5 == 0 );
+        ref.push_front( i % 5 == 0 );
+    }
+    check();
+
+    std::uint64_t word = 0xF0F0'0000'0000'0001ull;
+    bits.push_front_word( word );
+    bits.push_back_word( word );
+    for ( int j = 63; j >= 0; --j ) {
+        ref.push_front( ( word >> j ) & 1 );
+    }
+    for ( int j = 0; j < 64; ++j ) {
+        ref.push_back( ( word >> j ) & 1 );
+    }
+    check();
+
+    REQUIRE( bits.pop_back_word() == word );
+    REQUIRE( bits.pop_front_word() == word );
+    ref.erase( ref.begin(), ref.begin() + 64 );
+    ref.erase( ref.end() - 64, ref.end() );
+    check();
+
+    while ( !ref.empty() ) {
+        REQUIRE( bits.front() == ref.front() );
+        bits.pop_front();
+        ref.pop_front();
+        if ( !ref.empty() ) {
+            REQUIRE( bits.back() == ref.back() );
+            bits.pop_back();
+            ref.pop_back();
+        }
+        if ( ref.size() % 17 == 0 )
+            check();
+    }
+    REQUIRE( bits.empty() );
+    REQUIRE( bits.find_first_set() == Bits::npos );
+    REQUIRE_THROWS_AS( bits.pop_back(), const std::runtime_error & );
+
+    Bits key = { true, false, true };
+    key.push_front( true );
+    REQUIRE( key.to_vector() == std::vector< bool >( { true, true, false, true } ) );
+}
+
+TEST_CASE( "mapped reopen" ) {
+    auto path = std::filesystem::temp_directory_path() / "mapped_dvector_test.bin";
+    std::filesystem::remove( path );
+    {
+        MappedDVector< long > q( path.string(), 4 );
+        REQUIRE( q.capacity() == 4 );
+        for ( long i = 0; i < 10; ++i ) {
+            q.push_back( i );
+            q.push_front( -i - 1 );
+        }
+        q.pop_front();
+        q.pop_back();
+        q.flush();
+    }
+    {
+        MappedDVector< long > q( path.string() );
+        REQUIRE( q.size() == 18 );
+        REQUIRE( q.capacity() == 32 );
+        for ( long i = 0; i < 18; ++i ) {
+            REQUIRE( q[ i ] == i - 9 );
+        }
+        REQUIRE( q.front() == -9 );
+        REQUIRE( q.back() == 8 );
+        q.clear();
+    }
+    {
+        MappedDVector< long > q( path.string() );
+        REQUIRE( q.empty() );
+        REQUIRE_THROWS_AS( q.pop_front(), const std::runtime_error & );
+    }
+    REQUIRE_THROWS_AS( MappedDVector< int >( path.string() ), const std::runtime_error & );
+    std::filesystem::remove( path );
+}
+
+TEST_CASE( "snapshots are stable" ) {
+    SnapshotDVector< std::string, 4 > sv;
+    for ( int i = 0; i < 10; ++i ) {
+        sv.push_back( std::to_string( i ) );
+    }
+    auto snap = sv.snapshot();
+
+    sv.pop_front();
+    sv.pop_back();
+    sv.push_back( "x" );     // slot still visible to snap, chunk gets copied
+    sv.push_front( "y" );
+    sv[ 4 ] = "z";
+    for ( int i = 0; i < 10; ++i ) {
+        sv.push_back( "w" );
+    }
+
+    REQUIRE( snap.size() == 10 );
+    int i = 0;
+    for ( const auto &s : snap ) {
+        REQUIRE( s == std::to_string( i++ ) );
+    }
+    REQUIRE( sv.size() == 20 );
+    REQUIRE( sv.front() == "y" );
+    REQUIRE( sv[ 1 ] == "1" );
+    REQUIRE( sv[ 4 ] == "z" );
+    REQUIRE( sv[ 9 ] == "x" );
+    REQUIRE( sv.back() == "w" );
+
+    auto copy = sv;
+    while ( !sv.empty() ) {
+        sv.pop_back();
+    }
+    REQUIRE( copy.size() == 20 );
+    REQUIRE( copy[ 4 ] == "z" );
+    REQUIRE( snap[ 9 ] == "9" );
+}
+
+struct Counted {
+    static int live;
+    int v;
+
+    Counted( int v ) : v( v ) { ++live; }
+    Counted( const Counted &o ) : v( o.v ) { ++live; }
+    ~Counted() { --live; }
+};
+int Counted::live = 0;
+
+TEST_CASE( "snapshot released before push and pop" ) {
+    {
+        SnapshotDVector< Counted, 4 > sv;
+        for ( int i = 0; i < 3; ++i ) {
+            sv.push_back( Counted( i ) );
+        }
+        {
+            auto snap = sv.snapshot();
+            sv.pop_back();
+            sv.pop_front();
+        }
+        REQUIRE( Counted::live == 3 );   // popped elements stay until the chunk is modified
+
+        sv.push_back( Counted( 10 ) );
+        sv.push_front( Counted( 11 ) );
+        REQUIRE( Counted::live == 3 );
+        REQUIRE( sv.size() == 3 );
+        REQUIRE( sv[ 0 ].v == 11 );
+        REQUIRE( sv[ 1 ].v == 1 );
+        REQUIRE( sv[ 2 ].v == 10 );
+
+        {
+            auto snap = sv.snapshot();
+            sv.pop_front();
+            sv.pop_back();
+        }
+        sv.pop_front();
+        REQUIRE( sv.empty() );
+        REQUIRE( Counted::live == 0 );
+
+        for ( int i = 0; i < 6; ++i ) {
+            sv.push_front( Counted( i ) );
+        }
+        {
+            auto snap = sv.snapshot();
+            sv.pop_front();
+            sv.pop_back();
+        }
+        sv.pop_back();
+        sv.push_front( Counted( 20 ) );
+        sv.push_back( Counted( 21 ) );
+        REQUIRE( sv.size() == 5 );
+        REQUIRE( sv.front().v == 20 );
+        REQUIRE( sv.back().v == 21 );
+        REQUIRE( Counted::live == 5 );
+    }
+    REQUIRE( Counted::live == 0 );
+}
+
+TEST_CASE( "snapshot read concurrently" ) {
+    SnapshotDVector< long, 64 > sv;
+    for ( long i = 0; i < 1000; ++i ) {
+        sv.push_back( i );
+    }
+    auto snap = sv.snapshot();
+    long sum = 0;
+    std::thread reader( [&] {
+        for ( int round = 0; round < 20; ++round ) {
+            snap.for_each( [&]( long v ) { sum += v; } );
+        }
+    } );
+    for ( long i = 0; i < 5000; ++i ) {
+        sv.push_back( i );
+        sv.pop_front();
+        sv[ 100 ] = -1;
+    }
+    reader.join();
+    REQUIRE( sum == 20 * 999 * 1000 / 2 );
+    REQUIRE( sv.size() == 1000 );
+}
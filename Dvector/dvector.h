@@ -1,8 +1,12 @@
 #pragma once
 
+#include <algorithm>
+#include <functional>
 #include <iterator>
 #include <initializer_list>
+#include <limits>
 #include <memory>
+#include <stdexcept>
 #include <type_traits>
 
 // Several nice utilities for using uninitialised storage are available in C++17
@@ -37,14 +41,17 @@ public:
      * @brief	constructs default Dvector
      * 			does not allocate any space
      */
-    DVector() = default;
+    DVector() noexcept
+			: _head(0),
+			  _shift(0) {}
 
 	/**
 	 * @brief	constructs Dvector from initializer_list
 	 * 			allocates necessary space only once (does not reallocate)
 	 * @param 	ilist 		initializer_list of elements to be inserted
 	 */
-    DVector(std::initializer_list<T> ilist) {
+    DVector(std::initializer_list<T> ilist)
+			: DVector() {
         reserve(ilist.size());
         for (const auto& elem : ilist) {
             push_back(std::move(elem));
@@ -55,12 +62,13 @@ public:
 	 * @brief	constructs Dvector from range
 	 * 			should work with any iterator type
 	 * 			doesn't check whether iterators are valid in any way
-	 * 			might reallocate (reserves only for capacity of 10)
+	 * 			might reallocate (reserves only for capacity of 16)
 	 * @param 	begin		iterator to beginning of range
 	 * @param 	end			iterator to end of range
 	 */
     template< typename It >
-    DVector(It begin, It end) {
+    DVector(It begin, It end)
+			: DVector() {
         reserve(10);
         for (; begin != end; ++begin) {
             push_back(*begin);
@@ -78,7 +86,8 @@ public:
 	 * @brief	constructs Dvector as copy of other Dvector
 	 * @param 	o 			the other Dvector
 	 */
-    DVector(const DVector& o) {
+    DVector(const DVector& o)
+			: DVector() {
         reserve(o.size());
         for (const auto& elem : o)
             push_back(elem);
@@ -116,17 +125,13 @@ public:
 	 */
     DVector& operator=(DVector&& o) noexcept {
 		_deallocate();
-		_storage_begin = o._storage_begin;
-		_storage_end = o._storage_end;
-		_begin = o._begin;
-		_end = o._end;
-		_capacity = o._capacity;
+		_data = o._data;
+		_head = o._head;
+		_shift = o._shift;
 		_size = o._size;
-		o._storage_begin = nullptr;
-		o._storage_end = nullptr;
-		o._begin = nullptr;
-		o._end = nullptr;
-		o._capacity = 0;
+		o._data = nullptr;
+		o._head = 0;
+		o._shift = 0;
 		o._size = 0;
 		return *this;
 	}
@@ -249,7 +254,7 @@ public:
 	 * @return 	capacity of Buffer
 	 */
     std::size_t capacity() const {
-        return _capacity;
+        return _data ? std::size_t(1) << _shift : 0;
     }
 
 	/**
@@ -266,12 +271,11 @@ public:
 	 * 			invalidates all iterators
 	 */
     void clear() {
-		if (_begin > _end) {
-			std::destroy(_begin, _storage_end);
-			std::destroy(_storage_begin, _end);
-		} else {
-			std::destroy(_begin, _end);
-		}
+		std::size_t first = _first_segment();
+		std::destroy(_data + _head, _data + _head + first);
+		std::destroy(_data, _data + (_size - first));
+		_head = 0;
+		_size = 0;
 	}
 
 	/**
@@ -282,17 +286,13 @@ public:
 	 * @param 	n			new size
 	 */
     void resize(std::size_t n) {
-		if (n > _capacity)
-			_reallocate(n);
-		uint64_t diff = n - _size;
-
-		if (diff > 0) { //  n is greater than size - creating elements
-			std::uninitialized_value_construct(_end, _end + diff);
-			_end += diff;
-		} else {        //  n is lesser than size - removing elements from back
-			for (; diff != 0; ++diff)
-				pop_back();
+		reserve(n);
+		while (_size < n) {    //  n is greater than size - creating elements
+			new (_slot(_size)) T();
+			++_size;
 		}
+		while (_size > n)      //  n is lesser than size - removing elements from back
+			_pop(at::back);
     }
 
 	/**
@@ -302,8 +302,8 @@ public:
 	 * @param 	n			new capacity
 	 */
     void reserve(std::size_t n) {
-		if (n > _capacity)
-			_reallocate(n);
+		if (n > capacity())
+			_reallocate(_round_capacity(n));
     }
 
 	/**
@@ -313,26 +313,28 @@ public:
 	 */
     void swap(DVector& o) {
 		using std::swap;
-		swap(_storage_begin, o._storage_begin);
-		swap(_storage_end, o._storage_end);
-		swap(_begin, o._begin);
-		swap(_end, o._end);
-		swap(_capacity, o._capacity);
+		swap(_data, o._data);
 		swap(_size, o._size);
+		// bit-fields cannot be bound to references
+		std::size_t head = _head, shift = _shift;
+		_head = o._head;
+		_shift = o._shift;
+		o._head = head;
+		o._shift = shift;
 	}
 
 	/**
 	 * @return 	iterator to beginning
 	 */
     iterator begin() {
-        return iterator(_begin, _storage_begin, _storage_end);
+        return iterator(_data, _head, _mask());
     }
 
 	/**
 	 * @return 	const_iterator to beginning
 	 */
     const_iterator begin() const {
-        return const_iterator(_begin, _storage_begin, _storage_end);
+        return const_iterator(_data, _head, _mask());
     }
 
 	/**
@@ -346,14 +348,14 @@ public:
 	 * @return 	iterator to end
 	 */
     iterator end() {
-        return iterator(_end, _storage_begin, _storage_end);
+        return iterator(_data, _head + _size, _mask());
     }
 
 	/**
 	 * @return 	const_iterator to end
 	 */
     const_iterator end() const {
-        return const_iterator(_end, _storage_begin, _storage_end);
+        return const_iterator(_data, _head + _size, _mask());
     }
 
 	/**
@@ -383,39 +385,206 @@ public:
         return _reference(ix);
     }
 
+	/**
+	 * @brief	finds first element which is not less than key
+	 * 			Dvector has to be sorted with respect to comp
+	 * 			binary searches both contiguous parts of the ring directly
+	 * @param 	key
+	 * @param 	comp		comparator used for sorting
+	 * @return 	iterator to the found element or end()
+	 */
+	template <typename Key, typename Compare = std::less<>>
+	iterator lower_bound(const Key& key, Compare comp = Compare()) {
+		return _at(_lower_index(key, comp));
+	}
+
+	/**
+	 * @brief	const overload of lower_bound(const Key&, Compare)
+	 */
+	template <typename Key, typename Compare = std::less<>>
+	const_iterator lower_bound(const Key& key, Compare comp = Compare()) const {
+		return _at(_lower_index(key, comp));
+	}
+
+	/**
+	 * @brief	finds first element which is greater than key
+	 * 			Dvector has to be sorted with respect to comp
+	 * @param 	key
+	 * @param 	comp		comparator used for sorting
+	 * @return 	iterator to the found element or end()
+	 */
+	template <typename Key, typename Compare = std::less<>>
+	iterator upper_bound(const Key& key, Compare comp = Compare()) {
+		return _at(_upper_index(key, comp));
+	}
+
+	/**
+	 * @brief	const overload of upper_bound(const Key&, Compare)
+	 */
+	template <typename Key, typename Compare = std::less<>>
+	const_iterator upper_bound(const Key& key, Compare comp = Compare()) const {
+		return _at(_upper_index(key, comp));
+	}
+
+	/**
+	 * @brief	finds range of elements equivalent to key
+	 * 			Dvector has to be sorted with respect to comp
+	 * @param 	key
+	 * @param 	comp		comparator used for sorting
+	 * @return 	pair of lower_bound and upper_bound
+	 */
+	template <typename Key, typename Compare = std::less<>>
+	std::pair<iterator, iterator> equal_range(const Key& key, Compare comp = Compare()) {
+		return { lower_bound(key, comp), upper_bound(key, comp) };
+	}
+
+	/**
+	 * @brief	const overload of equal_range(const Key&, Compare)
+	 */
+	template <typename Key, typename Compare = std::less<>>
+	std::pair<const_iterator, const_iterator> equal_range(const Key& key, Compare comp = Compare()) const {
+		return { lower_bound(key, comp), upper_bound(key, comp) };
+	}
+
+	/**
+	 * @brief	removes all leading elements which are less than key
+	 * 			Dvector has to be sorted with respect to comp
+	 * 			invalidates iterators to the removed elements
+	 * 			other iterators remain valid
+	 * @param 	key
+	 * @param 	comp		comparator used for sorting
+	 * @return 	number of removed elements
+	 */
+	template <typename Key, typename Compare = std::less<>>
+	std::size_t trim_front_until(const Key& key, Compare comp = Compare()) {
+		std::size_t n = _lower_index(key, comp);
+		std::size_t first = std::min(n, _first_segment());
+		std::destroy(_data + _head, _data + _head + first);
+		std::destroy(_data, _data + (n - first));
+		if (n)
+			_head = (_head + n) & _mask();
+		_size -= n;
+		return n;
+	}
+
 private:
-	pointer _storage_begin = nullptr;
-	pointer _storage_end   = nullptr;
+	/**
+	 * 	compact layout - three words in total:
+	 * 		_data	storage of (1 << _shift) elements, nullptr if nothing is allocated
+	 * 		_head	index of the first element within the storage
+	 * 		_size	number of stored elements
+	 * 	capacity is always a power of two so that only its logarithm has to be
+	 * 	kept (packed together with _head) and ring indices wrap by masking
+	 */
+	static constexpr unsigned _shift_bits = 6;
+	static constexpr unsigned _head_bits = std::numeric_limits<std::size_t>::digits - _shift_bits;
+	static constexpr std::size_t _initial_capacity = 8;
+
+	pointer _data = nullptr;
+	std::size_t _head  : _head_bits;
+	std::size_t _shift : _shift_bits;
+	std::size_t _size = 0;
 
-	pointer _begin = nullptr;
-	pointer _end   = nullptr;
 
-	std::size_t _capacity = 0;
-	std::size_t _size     = 0;
+	/**
+	 * @brief	smallest valid capacity which can hold n elements
+	 * @param 	n
+	 * @return 	n rounded up to the power of two
+	 */
+	static std::size_t _round_capacity(std::size_t n) {
+		std::size_t capacity = 1;
+		while (capacity < n)
+			capacity <<= 1;
+		return capacity;
+	}
+
+	/**
+	 * @brief	mask used to wrap ring indices
+	 * @return 	capacity() - 1
+	 */
+	std::size_t _mask() const {
+		return capacity() - 1;
+	}
+
+	/**
+	 * @brief	address of x'th position counted from the first element
+	 * 			position does not need to hold a constructed element
+	 * @param 	x
+	 * @return 	pointer into the storage
+	 */
+	pointer _slot(std::size_t x) const {
+		return _data + ((_head + x) & _mask());
+	}
+
+	/**
+	 * @brief	number of elements stored between _head and the end of storage
+	 * 			remaining elements are wrapped to the beginning of storage
+	 * @return 	length of the first contiguous segment
+	 */
+	std::size_t _first_segment() const {
+		std::size_t tail = capacity() - _head;
+		return _size < tail ? _size : tail;
+	}
+
+	/**
+	 * @brief	iterator to x'th element
+	 * @param 	x
+	 * @return 	iterator
+	 */
+	iterator _at(std::size_t x) {
+		return iterator(_data, _head + x, _mask());
+	}
+	const_iterator _at(std::size_t x) const {
+		return const_iterator(_data, _head + x, _mask());
+	}
+
+	/**
+	 * @brief	finds position of the first element not satisfying pred
+	 * 			elements satisfying pred have to precede all the others
+	 * 			searches only that contiguous part of the ring which contains the position
+	 * @param 	pred
+	 * @return 	index of the element, size() if all elements satisfy pred
+	 */
+	template <typename Pred>
+	std::size_t _partition_index(Pred pred) const {
+		std::size_t first = _first_segment();
+		pointer segment = _data + _head;
+		if (first < _size && pred(segment[first - 1]))
+			return first + (std::partition_point(_data, _data + (_size - first), pred) - _data);
+		return std::partition_point(segment, segment + first, pred) - segment;
+	}
 
+	template <typename Key, typename Compare>
+	std::size_t _lower_index(const Key& key, Compare& comp) const {
+		return _partition_index([&](const_reference e) { return comp(e, key); });
+	}
+
+	template <typename Key, typename Compare>
+	std::size_t _upper_index(const Key& key, Compare& comp) const {
+		return _partition_index([&](const_reference e) { return !comp(key, e); });
+	}
 
 	/**
 	 * @brief	reallocates storage
 	 * 			prefers moving elements instead of copying them
-	 * @param 	n
+	 * @param 	n			new capacity, has to be a power of two
 	 */
 	void _reallocate(std::size_t n) {
-		pointer tmp_s_begin = Allocator().allocate(n + 1);
-		if (_storage_begin) {
-			if (_begin > _end) {
-				std::size_t offset = _storage_end - _begin;
-				std::uninitialized_move(_storage_end - offset, _storage_end, tmp_s_begin);
-				std::uninitialized_move(_storage_begin, _end, tmp_s_begin + offset);
-			} else {
-				std::uninitialized_move(_begin, _end, tmp_s_begin);
-			}
+		pointer tmp = Allocator().allocate(n);
+		std::size_t size = _size;
+		if (_data) {
+			std::size_t first = _first_segment();
+			std::uninitialized_move(_data + _head, _data + _head + first, tmp);
+			std::uninitialized_move(_data, _data + (_size - first), tmp + first);
 			_deallocate();
 		}
-		_storage_begin = tmp_s_begin;
-		_storage_end = _storage_begin + n + 1;
-		_begin = _storage_begin;
-		_end = _begin + _size;
-		_capacity = n;
+		std::size_t shift = 0;
+		while ((std::size_t(1) << shift) < n)
+			++shift;
+		_data = tmp;
+		_head = 0;
+		_shift = shift;
+		_size = size;
 	}
 
 	/**
@@ -433,16 +602,14 @@ private:
 		static_assert(std::is_same<_T, const T&>()
 					  || std::is_same<typename std::add_rvalue_reference<_T>::type, T&&>());
 
-		if (_size == _capacity)
-			_reallocate(!_capacity ? 10 : _capacity * 2);
+		if (_size == capacity())
+			_reallocate(!_size ? _initial_capacity : _size * 2);
 		if (where == at::front) {
-			if (_begin == _storage_begin)
-				_begin = _storage_end;
-			_create(--_begin, std::forward<_T>(value), std::is_lvalue_reference<_T>());
+			std::size_t head = (_head - 1) & _mask();
+			_create(_data + head, std::forward<_T>(value), std::is_lvalue_reference<_T>());
+			_head = head;
 		} else {
-			if (_end == _storage_end)
-				_end = _storage_begin;
-			_create(_end++, std::forward<_T>(value), std::is_lvalue_reference<_T>());
+			_create(_slot(_size), std::forward<_T>(value), std::is_lvalue_reference<_T>());
 		}
 		++_size;
 	}
@@ -476,13 +643,10 @@ private:
 	 */
 	void _pop(at where) {
 		if (where == at::front) {
-			std::destroy_at(_begin);
-			if (++_begin == _storage_end)
-				_begin = _storage_begin;
+			std::destroy_at(_data + _head);
+			_head = (_head + 1) & _mask();
 		} else {
-			if (_end == _storage_begin)
-				_end = _storage_end;
-			std::destroy_at(--_end);
+			std::destroy_at(_slot(_size - 1));
 		}
 		--_size;
 	}
@@ -495,19 +659,18 @@ private:
 	 * @return 	reference to element
 	 */
 	reference _reference(std::size_t x) const {
-		if (_begin > _end && _begin + x >= _storage_end) {
-			return *(_storage_begin + (x - (_storage_end - _begin)));
-		}
-		return *(_begin + x);
+		return *_slot(x);
 	}
 
 	/**
 	 * @brief	clears Buffer and deallocates storage owned by Buffer
 	 */
 	void _deallocate() {
-		if (_storage_begin) {
+		if (_data) {
+			std::size_t n = capacity();
 			clear();
-			Allocator().deallocate(_storage_begin, _capacity + 1);
+			Allocator().deallocate(_data, n);
+			_data = nullptr;
 		}
 	}
 
@@ -526,7 +689,9 @@ private:
 	/**
 	 * 	bidirectional iterator used by Buffer:
 	 * 		Iterator needs to "move" on cyclical interpretation
-	 * 		of Buffer - pointer to Buffer is providied to Iterator via constructors
+	 * 		of Buffer - it keeps unwrapped index of the element and wraps it
+	 * 		by the mask of Buffer's capacity when dereferenced, thus
+	 * 		begin and end differ even when Buffer is full
 	 */
 	template <typename _T>
 	class Iterator : public std::iterator<std::bidirectional_iterator_tag, typename std::iterator_traits<_T>::value_type > {
@@ -543,29 +708,37 @@ private:
 
 		/**
 		 * @brief	constructs Iterator with provided parameters
-		 * @param 	base
-		 * @param 	buf				pointer to Buffer
+		 * @param 	data			pointer to Buffer
+		 * @param 	index			unwrapped index of the element
+		 * @param 	mask			capacity of Buffer - 1
 		 */
-		Iterator(_T base, _T const bgn, _T const end)
-				: _current(base),
-				  _storage_begin(bgn),
-				  _storage_end(end) {}
+		Iterator(_T data, std::size_t index, std::size_t mask)
+				: _data(data),
+				  _index(index),
+				  _mask(mask) {}
 
 		/**
 		 * @brief	constructs Iterator as copy the other Iterator
 		 * @param 	it				the other Iterator
 		 */
 		Iterator(const Iterator& it)
-				: _current(it._current),
-				  _storage_begin(it._storage_begin),
-				  _storage_end(it._storage_end) {}
+				: _data(it._data),
+				  _index(it._index),
+				  _mask(it._mask) {}
+
+		/**
+		 * @brief	copy-assignment operator
+		 * @param 	it				the other Iterator
+		 * @return 	reference to this instance
+		 */
+		Iterator& operator=(const Iterator& it) = default;
 
 		/**
 		 * @brief	dereferencing operator
 		 * @return 	reference to the object Iterator is pointing to
 		 */
 		reference operator*() const {
-			return *_current;
+			return *operator->();
 		}
 
 		/**
@@ -573,7 +746,7 @@ private:
 		 * @return 	pointer to the object Iterator is pointing to
 		 */
 		pointer operator->() const {
-			return _current;
+			return _data + (_index & _mask);
 		}
 
 		/**
@@ -581,9 +754,7 @@ private:
 		 * @return 	reference to this instance after incrementation
 		 */
 		Iterator& operator++() {
-			++_current;
-			if (_current >= _storage_end)
-				_current = _storage_begin;
+			++_index;
 			return *this;
 		}
 
@@ -602,9 +773,7 @@ private:
 		 * @return 	reference to this instance after decrementation
 		 */
 		Iterator& operator--() {
-			--_current;
-			if (_current < _storage_begin)
-				_current = _storage_end - 1;
+			--_index;
 			return *this;
 		}
 
@@ -624,16 +793,17 @@ private:
 		 * @return	result of comparison
 		 */
 		bool operator==(const Iterator& it) const {
-			return _current == it._current;
+			return _data == it._data && _index == it._index;
 		}
 		bool operator!=(const Iterator& it) const {
 			return !(*this == it);
 		}
 
 	private:
-		_T _current = nullptr;
-		_T _storage_begin = nullptr;
-		_T _storage_end   = nullptr;
+		_T _data = nullptr;
+		std::size_t _index = 0;
+		std::size_t _mask = 0;
 	};
 }; // Dvector
 
+#include "dvector_bool.h"
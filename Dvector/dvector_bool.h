@@ -0,0 +1,414 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+/**
+ *  bit-packed specialization of DVector:
+ *  		works as double-ended queue of bits
+ *  		bits are packed by 64 into words which are kept in DVector of words,
+ *  		logical bit i is stored in bit (_offset + i) % 64 of word (_offset + i) / 64,
+ *  		bits outside of the queue are always zero
+ */
+template <typename Allocator>
+class DVector<bool, Allocator> {
+	using word_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<std::uint64_t>;
+
+	class ConstIterator;
+public:
+	using value_type = bool;
+	using word_type = std::uint64_t;
+	using const_reference = bool;
+	using iterator = ConstIterator;
+	using const_iterator = ConstIterator;
+
+	static constexpr std::size_t word_bits = 64;
+	static constexpr std::size_t npos = std::size_t(-1);
+
+	/**
+	 * @brief	constructs empty bit queue
+	 * 			does not allocate any space
+	 */
+	DVector() noexcept = default;
+
+	/**
+	 * @brief	constructs bit queue from initializer_list
+	 * @param 	ilist 		initializer_list of bits
+	 */
+	DVector(std::initializer_list<bool> ilist) {
+		reserve(ilist.size());
+		for (bool bit : ilist)
+			push_back(bit);
+	}
+
+	/**
+	 * @brief	constructs bit queue from range
+	 * @param 	begin		iterator to beginning of range
+	 * @param 	end			iterator to end of range
+	 */
+	template <typename It>
+	DVector(It begin, It end) {
+		for (; begin != end; ++begin)
+			push_back(bool(*begin));
+	}
+
+	/**
+	 * @brief	pushes bit to the back
+	 * @param 	bit
+	 */
+	void push_back(bool bit) {
+		std::size_t pos = _offset + _size;
+		if (pos % word_bits == 0)
+			_words.push_back(0);
+		if (bit)
+			_words.back() |= word_type(1) << (pos % word_bits);
+		++_size;
+	}
+
+	/**
+	 * @brief	pushes bit to the front
+	 * @param 	bit
+	 */
+	void push_front(bool bit) {
+		if (_offset == 0) {
+			_words.push_front(0);
+			_offset = word_bits;
+		}
+		--_offset;
+		if (bit)
+			_words.front() |= word_type(1) << _offset;
+		++_size;
+	}
+
+	/**
+	 * @brief	pushes 64 bits to the back
+	 * 			bit j of word becomes bit size() + j of the queue
+	 * @param 	word
+	 */
+	void push_back_word(word_type word) {
+		std::size_t shift = (_offset + _size) % word_bits;
+		if (shift == 0) {
+			_words.push_back(word);
+		} else {
+			_words.back() |= word << shift;
+			_words.push_back(word >> (word_bits - shift));
+		}
+		_size += word_bits;
+	}
+
+	/**
+	 * @brief	pushes 64 bits to the front
+	 * 			bit j of word becomes bit j of the queue
+	 * @param 	word
+	 */
+	void push_front_word(word_type word) {
+		if (_offset == 0) {
+			_words.push_front(word);
+		} else {
+			_words.push_front(word << _offset);
+			_words[1] |= word >> (word_bits - _offset);
+		}
+		_size += word_bits;
+	}
+
+	/**
+	 * @brief	removes the first bit
+	 * @throw	std::runtime_error if bit queue is empty
+	 */
+	void pop_front() {
+		_check(1);
+		_words.front() &= ~(word_type(1) << _offset);
+		++_offset;
+		--_size;
+		if (_offset == word_bits) {
+			_words.pop_front();
+			_offset = 0;
+		}
+		if (!_size)
+			clear();
+	}
+
+	/**
+	 * @brief	removes the last bit
+	 * @throw	std::runtime_error if bit queue is empty
+	 */
+	void pop_back() {
+		_check(1);
+		--_size;
+		std::size_t pos = _offset + _size;
+		_words.back() &= ~(word_type(1) << (pos % word_bits));
+		if (pos % word_bits == 0)
+			_words.pop_back();
+		if (!_size)
+			clear();
+	}
+
+	/**
+	 * @brief	removes the first 64 bits
+	 * @throw	std::runtime_error if bit queue holds less than 64 bits
+	 * @return 	removed bits, bit j of the result was bit j of the queue
+	 */
+	word_type pop_front_word() {
+		_check(word_bits);
+		word_type word = _window(0);
+		_words.pop_front();
+		if (_offset)
+			_words.front() &= ~word_type(0) << _offset;
+		_size -= word_bits;
+		if (!_size)
+			clear();
+		return word;
+	}
+
+	/**
+	 * @brief	removes the last 64 bits
+	 * @throw	std::runtime_error if bit queue holds less than 64 bits
+	 * @return 	removed bits, bit j of the result was bit size() - 64 + j of the queue
+	 */
+	word_type pop_back_word() {
+		_check(word_bits);
+		word_type word = _window(_size - word_bits);
+		_size -= word_bits;
+		std::size_t shift = (_offset + _size) % word_bits;
+		_words.pop_back();
+		if (shift)
+			_words.back() &= ~(~word_type(0) << shift);
+		if (!_size)
+			clear();
+		return word;
+	}
+
+	/**
+	 * @throw	std::runtime_error if bit queue is empty
+	 * @return	the first bit
+	 */
+	bool front() const {
+		_check(1);
+		return (*this)[0];
+	}
+
+	/**
+	 * @throw	std::runtime_error if bit queue is empty
+	 * @return	the last bit
+	 */
+	bool back() const {
+		_check(1);
+		return (*this)[_size - 1];
+	}
+
+	/**
+	 * @brief	access bit in ix'th position
+	 * 			does no checks whatsoever
+	 * @param 	ix 			position
+	 * @return 	value of the bit
+	 */
+	bool operator[](std::size_t ix) const {
+		std::size_t pos = _offset + ix;
+		return (_words[pos / word_bits] >> (pos % word_bits)) & 1;
+	}
+
+	/**
+	 * @brief	sets bit in ix'th position
+	 * 			does no checks whatsoever
+	 * @param 	ix 			position
+	 * @param 	bit			new value
+	 */
+	void set(std::size_t ix, bool bit) {
+		std::size_t pos = _offset + ix;
+		word_type mask = word_type(1) << (pos % word_bits);
+		if (bit)
+			_words[pos / word_bits] |= mask;
+		else
+			_words[pos / word_bits] &= ~mask;
+	}
+
+	/**
+	 * @brief	64 consecutive bits of the queue
+	 * 			bits past the end of the queue are zero
+	 * @param 	ix 			position of the first bit, has to be less than size()
+	 * @return 	bit j of the result is bit ix + j of the queue
+	 */
+	word_type word(std::size_t ix) const {
+		return _window(ix);
+	}
+
+	/**
+	 * @return 	number of set bits
+	 */
+	std::size_t popcount() const noexcept {
+		std::size_t count = 0;
+		for (std::size_t i = 0, n = _words.size(); i < n; ++i)
+			count += std::popcount(_words[i]);
+		return count;
+	}
+
+	/**
+	 * @brief	finds the first set bit, scanning word by word
+	 * @param 	from		position where the search starts
+	 * @return 	position of the first set bit not before from, npos if there is none
+	 */
+	std::size_t find_first_set(std::size_t from = 0) const noexcept {
+		for (std::size_t ix = from; ix < _size; ix += word_bits) {
+			word_type word = _window(ix);
+			if (word)
+				return ix + std::countr_zero(word);
+		}
+		return npos;
+	}
+
+	/**
+	 * @brief	copies bits into std::vector<bool>
+	 * 			(the key type of Trie)
+	 * @return 	vector of bits in the queue order
+	 */
+	std::vector<bool> to_vector() const {
+		return std::vector<bool>(begin(), end());
+	}
+
+	/**
+	 * @return	true if no bits are stored, false otherwise
+	 */
+	bool empty() const noexcept {
+		return _size == 0;
+	}
+
+	/**
+	 * @return 	number of stored bits
+	 */
+	std::size_t size() const noexcept {
+		return _size;
+	}
+
+	/**
+	 * @return 	number of bits which fit into allocated storage
+	 */
+	std::size_t capacity() const noexcept {
+		return _words.capacity() * word_bits;
+	}
+
+	/**
+	 * @brief	makes capacity at least n bits
+	 * @param 	n
+	 */
+	void reserve(std::size_t n) {
+		_words.reserve((n + word_bits - 1) / word_bits + 1);
+	}
+
+	/**
+	 * @brief	removes all bits, keeps allocated storage
+	 */
+	void clear() noexcept {
+		_words.clear();
+		_offset = 0;
+		_size = 0;
+	}
+
+	/**
+	 * @brief	swaps with the other bit queue
+	 * @param 	o 			the other bit queue
+	 */
+	void swap(DVector& o) noexcept {
+		using std::swap;
+		_words.swap(o._words);
+		swap(_offset, o._offset);
+		swap(_size, o._size);
+	}
+
+	const_iterator begin() const {
+		return const_iterator(this, 0);
+	}
+	const_iterator cbegin() const {
+		return begin();
+	}
+	const_iterator end() const {
+		return const_iterator(this, _size);
+	}
+	const_iterator cend() const {
+		return end();
+	}
+
+private:
+	DVector<word_type, word_allocator> _words;
+	std::size_t _offset = 0;
+	std::size_t _size = 0;
+
+
+	/**
+	 * @brief	assembles 64 bits starting at logical position ix
+	 * 			from at most two stored words
+	 * @param 	ix
+	 * @return 	bits, bits past the end of the queue are zero
+	 */
+	word_type _window(std::size_t ix) const {
+		std::size_t pos = _offset + ix;
+		std::size_t w = pos / word_bits, shift = pos % word_bits;
+		word_type word = _words[w] >> shift;
+		if (shift && w + 1 < _words.size())
+			word |= _words[w + 1] << (word_bits - shift);
+		std::size_t left = _size - ix;
+		if (left < word_bits)
+			word &= (word_type(1) << left) - 1;
+		return word;
+	}
+
+	/**
+	 * @throw	std::runtime_error if less than n bits are stored
+	 */
+	void _check(std::size_t n) const {
+		if (_size < n)
+			throw std::runtime_error("vector is empty");
+	}
+
+	/**
+	 * 	read-only bidirectional iterator yielding bits by value
+	 */
+	class ConstIterator {
+	public:
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = bool;
+		using difference_type = std::ptrdiff_t;
+		using reference = bool;
+		using pointer = void;
+
+		ConstIterator() = default;
+
+		ConstIterator(const DVector* owner, std::size_t index)
+				: _owner(owner),
+				  _index(index) {}
+
+		bool operator*() const {
+			return (*_owner)[_index];
+		}
+
+		ConstIterator& operator++() {
+			++_index;
+			return *this;
+		}
+		ConstIterator operator++(int) {
+			ConstIterator tmp = *this;
+			++_index;
+			return tmp;
+		}
+		ConstIterator& operator--() {
+			--_index;
+			return *this;
+		}
+		ConstIterator operator--(int) {
+			ConstIterator tmp = *this;
+			--_index;
+			return tmp;
+		}
+
+		bool operator==(const ConstIterator& it) const {
+			return _owner == it._owner && _index == it._index;
+		}
+		bool operator!=(const ConstIterator& it) const {
+			return !(*this == it);
+		}
+
+	private:
+		const DVector* _owner = nullptr;
+		std::size_t _index = 0;
+	};
+}; // DVector<bool>
@@ -0,0 +1,339 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ *  DVector whose storage is a memory-mapped file (POSIX only):
+ *  		file starts with a header holding begin, end and capacity
+ *  		followed by the ring of capacity elements,
+ *  		reopening the file recovers the queue in O(1) without any parsing
+ *  		begin and end are unwrapped positions (element i lives in slot i % capacity)
+ *  		so that every operation updates a single header field after the element
+ *  		is written, thus a crashed process never leaves a partially written
+ *  		element inside the queue
+ */
+template <typename T>
+class MappedDVector {
+	static_assert(std::is_trivially_copyable<T>::value, "elements are stored as raw bytes");
+
+	enum class at {
+		front,
+		back
+	}; // enum class at
+
+	struct Header {
+		std::uint64_t magic;
+		std::uint32_t version;
+		std::uint32_t element_size;
+		std::uint64_t begin;
+		std::uint64_t end;
+		std::uint64_t capacity;
+	};
+
+	static constexpr std::uint64_t _magic = 0x5245544345564444ull;  // "DDVECTER"
+	static constexpr std::uint32_t _version = 1;
+	static constexpr std::size_t _data_offset = 64;
+	static constexpr std::size_t _initial_capacity = 64;
+
+	static_assert(sizeof(Header) <= _data_offset, "header does not fit");
+
+public:
+	using value_type = T;
+	using reference = T&;
+	using const_reference = const T&;
+
+	/**
+	 * @brief	opens queue stored in the file, creates the file if it does not exist
+	 * @param 	path		path to the file
+	 * @param 	capacity	initial capacity of a newly created queue
+	 * @throw	std::system_error if the file cannot be opened or mapped
+	 * @throw	std::runtime_error if the file does not contain a compatible queue
+	 */
+	explicit MappedDVector(const std::string& path, std::size_t capacity = _initial_capacity) {
+		_fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+		if (_fd < 0)
+			_fail("open");
+		struct stat st;
+		if (::fstat(_fd, &st) < 0) {
+			::close(_fd);
+			_fail("fstat");
+		}
+		try {
+			if (st.st_size == 0) {
+				_create(_round_capacity(capacity));
+			} else {
+				_map(st.st_size);
+				_validate(st.st_size);
+			}
+		} catch (...) {
+			_unmap();
+			::close(_fd);
+			throw;
+		}
+	}
+
+	MappedDVector(const MappedDVector&) = delete;
+	MappedDVector& operator=(const MappedDVector&) = delete;
+
+	/**
+	 * @brief	flushes and unmaps the file
+	 */
+	~MappedDVector() {
+		if (_header)
+			::msync(_header, _length, MS_ASYNC);
+		_unmap();
+		::close(_fd);
+	}
+
+	/**
+	 * @brief	writes dirty pages of the mapping back to the file
+	 * @param 	wait		block until data reach the storage device
+	 * @throw	std::system_error if msync fails
+	 */
+	void flush(bool wait = true) {
+		if (::msync(_header, _length, wait ? MS_SYNC : MS_ASYNC) < 0)
+			_fail("msync");
+	}
+
+	/**
+	 * @brief	pushes value to the back
+	 * 			can grow and remap the file, which invalidates all references
+	 * @param 	value
+	 */
+	void push_back(const_reference value) {
+		_push(value, at::back);
+	}
+
+	/**
+	 * @brief	pushes value to the front
+	 * 			can grow and remap the file, which invalidates all references
+	 * @param 	value
+	 */
+	void push_front(const_reference value) {
+		_push(value, at::front);
+	}
+
+	/**
+	 * @brief	removes the first element
+	 * @throw	std::runtime_error if queue is empty
+	 */
+	void pop_front() {
+		_check();
+		++_header->begin;
+	}
+
+	/**
+	 * @brief	removes the last element
+	 * @throw	std::runtime_error if queue is empty
+	 */
+	void pop_back() {
+		_check();
+		--_header->end;
+	}
+
+	/**
+	 * @throw	std::runtime_error if queue is empty
+	 * @return	reference to the first element
+	 */
+	reference front() {
+		_check();
+		return (*this)[0];
+	}
+	const_reference front() const {
+		_check();
+		return (*this)[0];
+	}
+
+	/**
+	 * @throw	std::runtime_error if queue is empty
+	 * @return	reference to the last element
+	 */
+	reference back() {
+		_check();
+		return (*this)[size() - 1];
+	}
+	const_reference back() const {
+		_check();
+		return (*this)[size() - 1];
+	}
+
+	/**
+	 * @brief	access element in ix'th position
+	 * 			does no checks whatsoever
+	 * @param 	ix 			position
+	 * @return 	reference into the mapped file
+	 */
+	reference operator[](std::size_t ix) {
+		return _data()[(_header->begin + ix) & _mask()];
+	}
+	const_reference operator[](std::size_t ix) const {
+		return _data()[(_header->begin + ix) & _mask()];
+	}
+
+	/**
+	 * @return	true if queue is empty, false otherwise
+	 */
+	bool empty() const noexcept {
+		return size() == 0;
+	}
+
+	/**
+	 * @return 	number of stored elements
+	 */
+	std::size_t size() const noexcept {
+		return _header->end - _header->begin;
+	}
+
+	/**
+	 * @return 	number of elements which fit into the file
+	 */
+	std::size_t capacity() const noexcept {
+		return _header->capacity;
+	}
+
+	/**
+	 * @brief	makes capacity at least n
+	 * 			grows the file and remaps it, invalidates all references
+	 * @param 	n			new capacity
+	 */
+	void reserve(std::size_t n) {
+		if (n > capacity())
+			_grow(_round_capacity(n));
+	}
+
+	/**
+	 * @brief	removes all elements, keeps the file size
+	 */
+	void clear() noexcept {
+		_header->begin = _header->end;
+	}
+
+private:
+	int _fd = -1;
+	Header* _header = nullptr;
+	std::size_t _length = 0;
+
+
+	static std::size_t _round_capacity(std::size_t n) {
+		std::size_t capacity = 1;
+		while (capacity < n)
+			capacity <<= 1;
+		return capacity;
+	}
+
+	static std::size_t _file_length(std::size_t capacity) {
+		return _data_offset + capacity * sizeof(T);
+	}
+
+	[[noreturn]] static void _fail(const char* what) {
+		throw std::system_error(errno, std::generic_category(), what);
+	}
+
+	T* _data() const noexcept {
+		return reinterpret_cast<T*>(reinterpret_cast<char*>(_header) + _data_offset);
+	}
+
+	std::size_t _mask() const noexcept {
+		return _header->capacity - 1;
+	}
+
+	void _map(std::size_t length) {
+		void* addr = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+		if (addr == MAP_FAILED)
+			_fail("mmap");
+		_header = static_cast<Header*>(addr);
+		_length = length;
+	}
+
+	void _unmap() noexcept {
+		if (_header)
+			::munmap(_header, _length);
+		_header = nullptr;
+		_length = 0;
+	}
+
+	/**
+	 * @brief	initializes empty file
+	 * @param 	capacity	has to be a power of two
+	 */
+	void _create(std::size_t capacity) {
+		if (::ftruncate(_fd, _file_length(capacity)) < 0)
+			_fail("ftruncate");
+		_map(_file_length(capacity));
+		*_header = Header{ _magic, _version, sizeof(T), 0, 0, capacity };
+	}
+
+	/**
+	 * @brief	checks that the mapped file holds queue of this type
+	 * @param 	length		length of the file
+	 * @throw	std::runtime_error if it does not
+	 */
+	void _validate(std::size_t length) const {
+		if (length < _data_offset || _header->magic != _magic || _header->version != _version)
+			throw std::runtime_error("file does not contain MappedDVector");
+		if (_header->element_size != sizeof(T))
+			throw std::runtime_error("MappedDVector element size mismatch");
+		std::uint64_t capacity = _header->capacity;
+		if (!capacity || (capacity & (capacity - 1)) || length < _file_length(capacity)
+			|| size() > capacity)
+			throw std::runtime_error("MappedDVector header is corrupted");
+	}
+
+	/**
+	 * @brief	extends the file and remaps it
+	 * 			elements whose slot changes with the new capacity are copied
+	 * 			into the newly added part of the file, the old slots stay intact
+	 * 			until capacity in the header is updated as the last step
+	 * @param 	n			new capacity, has to be a power of two
+	 */
+	void _grow(std::size_t n) {
+		std::size_t old_capacity = capacity();
+		if (::ftruncate(_fd, _file_length(n)) < 0)
+			_fail("ftruncate");
+		std::size_t old_length = _length;
+		void* addr = ::mmap(nullptr, _file_length(n), PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+		if (addr == MAP_FAILED)
+			_fail("mmap");
+		::munmap(_header, old_length);
+		_header = static_cast<Header*>(addr);
+		_length = _file_length(n);
+
+		for (std::uint64_t i = _header->begin; i != _header->end; ++i) {
+			std::size_t from = i & (old_capacity - 1), to = i & (n - 1);
+			if (from != to)
+				std::memcpy(_data() + to, _data() + from, sizeof(T));
+		}
+		_header->capacity = n;
+	}
+
+	void _push(const_reference value, at where) {
+		if (size() == capacity())
+			_grow(capacity() * 2);
+		if (where == at::front) {
+			_data()[(_header->begin - 1) & _mask()] = value;
+			--_header->begin;
+		} else {
+			_data()[_header->end & _mask()] = value;
+			++_header->end;
+		}
+	}
+
+	/**
+	 * @throw	std::runtime_error if queue is empty
+	 */
+	void _check() const {
+		if (empty())
+			throw std::runtime_error("vector is empty");
+	}
+}; // MappedDVector
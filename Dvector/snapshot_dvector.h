@@ -0,0 +1,473 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+
+#include "dvector.h"
+
+/**
+ *  DVector made of reference-counted chunks which supports cheap snapshots:
+ *  		snapshot() shares all chunks with the returned Snapshot (O(chunks)),
+ *  		the writer then never changes an element visible to any snapshot -
+ *  		it appends only into slots of a chunk which have never been constructed
+ *  		and copies a shared chunk before modifying it in any other way
+ *  		Snapshot is immutable and can be read from other threads while
+ *  		the writer keeps pushing and popping
+ */
+template <typename T, std::size_t ChunkSize = 256>
+class SnapshotDVector {
+	static_assert(ChunkSize > 0, "chunk cannot be empty");
+
+	/**
+	 * 	fixed block of slots, slots [lo, hi) hold constructed elements
+	 */
+	struct Chunk {
+		std::size_t lo;
+		std::size_t hi;
+		alignas(T) unsigned char storage[ChunkSize * sizeof(T)];
+
+		Chunk(std::size_t lo, std::size_t hi) noexcept
+				: lo(lo),
+				  hi(hi) {}
+
+		Chunk(const Chunk&) = delete;
+		Chunk& operator=(const Chunk&) = delete;
+
+		~Chunk() {
+			for (std::size_t i = lo; i < hi; ++i)
+				std::destroy_at(slot(i));
+		}
+
+		T* slot(std::size_t i) noexcept {
+			return std::launder(reinterpret_cast<T*>(storage) + i);
+		}
+		const T* slot(std::size_t i) const noexcept {
+			return std::launder(reinterpret_cast<const T*>(storage) + i);
+		}
+	};
+
+	using ChunkPtr = std::shared_ptr<Chunk>;
+	using Chunks = DVector<ChunkPtr>;
+
+public:
+	using value_type = T;
+	using reference = T&;
+	using const_reference = const T&;
+
+	class Snapshot;
+
+	/**
+	 * @brief	constructs empty SnapshotDVector
+	 */
+	SnapshotDVector() = default;
+
+	/**
+	 * @brief	constructs SnapshotDVector as deep copy of the other one
+	 * 			(chunks are shared only with snapshots, never between writers)
+	 * @param 	o 			the other SnapshotDVector
+	 */
+	SnapshotDVector(const SnapshotDVector& o) {
+		for (std::size_t i = 0; i < o.size(); ++i)
+			push_back(o[i]);
+	}
+
+	SnapshotDVector(SnapshotDVector&& o) noexcept {
+		swap(o);
+	}
+
+	SnapshotDVector& operator=(const SnapshotDVector& o) {
+		SnapshotDVector tmp = o;
+		swap(tmp);
+		return *this;
+	}
+
+	SnapshotDVector& operator=(SnapshotDVector&& o) noexcept {
+		SnapshotDVector tmp = std::move(o);
+		swap(tmp);
+		return *this;
+	}
+
+	/**
+	 * @brief	takes consistent read-only view of current content
+	 * 			costs one reference count increment per chunk, copies no element
+	 * 			has to be called from the writer thread
+	 * @return 	snapshot which can be handed to any thread
+	 */
+	Snapshot snapshot() const {
+		return Snapshot(_chunks, _offset, _size);
+	}
+
+	/**
+	 * @brief	pushes value to the back
+	 * 			copies the last chunk if it is shared and the slot has been used before
+	 * @param 	val			value
+	 */
+	void push_back(const_reference val) {
+		_emplace_back(val);
+	}
+	void push_back(T&& val) {
+		_emplace_back(std::move(val));
+	}
+
+	/**
+	 * @brief	pushes value to the front
+	 * 			copies the first chunk if it is shared and the slot has been used before
+	 * @param 	val			value
+	 */
+	void push_front(const_reference val) {
+		_emplace_front(val);
+	}
+	void push_front(T&& val) {
+		_emplace_front(std::move(val));
+	}
+
+	/**
+	 * @brief	removes the first element
+	 * 			element is destroyed only if no snapshot can see it
+	 * @throw	std::runtime_error if SnapshotDVector is empty
+	 */
+	void pop_front() {
+		_check();
+		Chunk& chunk = *_chunks.front();
+		if (_exclusive(_chunks.front())) {
+			_trim(0);
+			std::destroy_at(chunk.slot(_offset));
+			chunk.lo = _offset + 1;
+		}
+		++_offset;
+		--_size;
+		if (!_size)
+			clear();
+		else if (_offset == ChunkSize) {
+			_chunks.pop_front();
+			_offset = 0;
+		}
+	}
+
+	/**
+	 * @brief	removes the last element
+	 * 			element is destroyed only if no snapshot can see it
+	 * @throw	std::runtime_error if SnapshotDVector is empty
+	 */
+	void pop_back() {
+		_check();
+		std::size_t slot = (_offset + _size - 1) % ChunkSize;
+		Chunk& chunk = *_chunks.back();
+		if (_exclusive(_chunks.back())) {
+			_trim(_chunks.size() - 1);
+			std::destroy_at(chunk.slot(slot));
+			chunk.hi = slot;
+		}
+		--_size;
+		if (!_size)
+			clear();
+		else if (slot == 0)
+			_chunks.pop_back();
+	}
+
+	/**
+	 * @brief	access element in ix'th position for modification
+	 * 			copies the chunk holding the element if it is shared
+	 * 			does no bounds checks
+	 * @param 	ix 			position
+	 * @return 	reference to the element
+	 */
+	reference operator[](std::size_t ix) {
+		std::size_t pos = _offset + ix;
+		_own(pos / ChunkSize);
+		return *_chunks[pos / ChunkSize]->slot(pos % ChunkSize);
+	}
+
+	/**
+	 * @brief	access element in ix'th position
+	 * 			does no checks whatsoever
+	 * @param 	ix 			position
+	 * @return 	const reference to the element
+	 */
+	const_reference operator[](std::size_t ix) const {
+		std::size_t pos = _offset + ix;
+		return *_chunks[pos / ChunkSize]->slot(pos % ChunkSize);
+	}
+
+	/**
+	 * @throw	std::runtime_error if SnapshotDVector is empty
+	 * @return	reference to the first element (its chunk is copied if shared)
+	 */
+	reference front() {
+		_check();
+		return (*this)[0];
+	}
+	const_reference front() const {
+		_check();
+		return (*this)[0];
+	}
+
+	/**
+	 * @throw	std::runtime_error if SnapshotDVector is empty
+	 * @return	reference to the last element (its chunk is copied if shared)
+	 */
+	reference back() {
+		_check();
+		return (*this)[_size - 1];
+	}
+	const_reference back() const {
+		_check();
+		return (*this)[_size - 1];
+	}
+
+	/**
+	 * @return	true if SnapshotDVector is empty, false otherwise
+	 */
+	bool empty() const noexcept {
+		return _size == 0;
+	}
+
+	/**
+	 * @return 	number of stored elements
+	 */
+	std::size_t size() const noexcept {
+		return _size;
+	}
+
+	/**
+	 * @brief	releases all chunks
+	 * 			chunks still referenced by snapshots stay alive until those are gone
+	 */
+	void clear() noexcept {
+		_chunks.clear();
+		_offset = 0;
+		_size = 0;
+	}
+
+	/**
+	 * @brief	swaps with the other SnapshotDVector
+	 * @param 	o 			the other SnapshotDVector
+	 */
+	void swap(SnapshotDVector& o) noexcept {
+		using std::swap;
+		_chunks.swap(o._chunks);
+		swap(_offset, o._offset);
+		swap(_size, o._size);
+	}
+
+	/**
+	 * 	immutable view of SnapshotDVector at the moment of snapshot()
+	 */
+	class Snapshot {
+	public:
+		class const_iterator;
+
+		Snapshot() = default;
+
+		const_reference operator[](std::size_t ix) const {
+			std::size_t pos = _offset + ix;
+			return *_chunks[pos / ChunkSize]->slot(pos % ChunkSize);
+		}
+
+		bool empty() const noexcept {
+			return _size == 0;
+		}
+
+		std::size_t size() const noexcept {
+			return _size;
+		}
+
+		const_iterator begin() const {
+			return const_iterator(this, 0);
+		}
+
+		const_iterator end() const {
+			return const_iterator(this, _size);
+		}
+
+		/**
+		 * @brief	calls f on every element in order, chunk by chunk
+		 * @param 	f
+		 */
+		template <typename F>
+		void for_each(F f) const {
+			std::size_t pos = _offset, left = _size;
+			for (std::size_t c = 0; left; ++c, pos = 0) {
+				const Chunk& chunk = *_chunks[c];
+				std::size_t n = ChunkSize - pos < left ? ChunkSize - pos : left;
+				for (std::size_t i = pos; i < pos + n; ++i)
+					f(*chunk.slot(i));
+				left -= n;
+			}
+		}
+
+		/**
+		 * 	forward iterator over Snapshot
+		 */
+		class const_iterator {
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = T;
+			using difference_type = std::ptrdiff_t;
+			using reference = const T&;
+			using pointer = const T*;
+
+			const_iterator() = default;
+
+			const_iterator(const Snapshot* owner, std::size_t index)
+					: _owner(owner),
+					  _index(index) {}
+
+			reference operator*() const {
+				return (*_owner)[_index];
+			}
+			pointer operator->() const {
+				return &(*_owner)[_index];
+			}
+
+			const_iterator& operator++() {
+				++_index;
+				return *this;
+			}
+			const_iterator operator++(int) {
+				const_iterator tmp = *this;
+				++_index;
+				return tmp;
+			}
+
+			bool operator==(const const_iterator& it) const {
+				return _owner == it._owner && _index == it._index;
+			}
+			bool operator!=(const const_iterator& it) const {
+				return !(*this == it);
+			}
+
+		private:
+			const Snapshot* _owner = nullptr;
+			std::size_t _index = 0;
+		};
+
+	private:
+		friend class SnapshotDVector;
+
+		Chunks _chunks;
+		std::size_t _offset = 0;
+		std::size_t _size = 0;
+
+		Snapshot(const Chunks& chunks, std::size_t offset, std::size_t size)
+				: _chunks(chunks),
+				  _offset(offset),
+				  _size(size) {}
+	};
+
+private:
+	Chunks _chunks;
+	std::size_t _offset = 0;     // position of the first element within the first chunk
+	std::size_t _size = 0;
+
+
+	/**
+	 * @brief	checks whether chunk is referenced only by this instance
+	 * 			the acquire fence pairs with the release decrement of the last
+	 * 			snapshot which dropped the chunk, so its reads happen before
+	 * 			any subsequent modification
+	 * @param 	chunk
+	 * @return 	true if chunk can be modified in place
+	 */
+	static bool _exclusive(const ChunkPtr& chunk) noexcept {
+		if (chunk.use_count() != 1)
+			return false;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return true;
+	}
+
+	/**
+	 * @brief	replaces c'th chunk by private copy if it is shared
+	 * 			the copy holds only elements visible to this instance
+	 * @param 	c			index of chunk
+	 */
+	void _own(std::size_t c) {
+		if (_exclusive(_chunks[c]))
+			return;
+		std::size_t lo = c == 0 ? _offset : 0;
+		std::size_t end = _offset + _size;
+		std::size_t hi = (c + 1) * ChunkSize <= end ? ChunkSize : end - c * ChunkSize;
+		auto copy = std::make_shared<Chunk>(lo, lo);
+		for (; copy->hi < hi; ++copy->hi)
+			new (copy->slot(copy->hi)) T(*_chunks[c]->slot(copy->hi));
+		_chunks[c] = std::move(copy);
+	}
+
+	/**
+	 * @brief	destroys elements of exclusive c'th chunk which are outside of this instance
+	 * 			(left there by pops while the chunk was shared with a snapshot)
+	 * 			so that [lo, hi) of the chunk is exactly its part of the content
+	 * @param 	c			index of chunk
+	 */
+	void _trim(std::size_t c) noexcept {
+		Chunk& chunk = *_chunks[c];
+		std::size_t start = c * ChunkSize, end = _offset + _size;
+		std::size_t lo = c == 0 ? _offset : 0;
+		std::size_t hi = end < start + ChunkSize ? end - start : ChunkSize;
+		for (; chunk.lo < lo; ++chunk.lo)
+			std::destroy_at(chunk.slot(chunk.lo));
+		for (; chunk.hi > hi; --chunk.hi)
+			std::destroy_at(chunk.slot(chunk.hi - 1));
+	}
+
+	template <typename U>
+	void _emplace_back(U&& val) {
+		std::size_t slot = (_offset + _size) % ChunkSize;
+		bool fresh = slot == 0;
+		if (fresh)
+			_chunks.push_back(std::make_shared<Chunk>(0, 0));
+		else if (_exclusive(_chunks.back()))
+			_trim(_chunks.size() - 1);
+		else if (_chunks.back()->hi != slot)   // slot is still visible to a snapshot
+			_own(_chunks.size() - 1);
+		Chunk& chunk = *_chunks.back();
+		try {
+			new (chunk.slot(slot)) T(std::forward<U>(val));
+		} catch (...) {
+			if (fresh)
+				_chunks.pop_back();
+			throw;
+		}
+		chunk.hi = slot + 1;
+		++_size;
+	}
+
+	template <typename U>
+	void _emplace_front(U&& val) {
+		bool fresh = _offset == 0;
+		if (fresh) {
+			_chunks.push_front(std::make_shared<Chunk>(ChunkSize, ChunkSize));
+			_offset = ChunkSize;
+		} else if (_exclusive(_chunks.front())) {
+			_trim(0);
+		} else if (_chunks.front()->lo != _offset) {   // slot is still visible to a snapshot
+			_own(0);
+		}
+		std::size_t slot = _offset - 1;
+		Chunk& chunk = *_chunks.front();
+		try {
+			new (chunk.slot(slot)) T(std::forward<U>(val));
+		} catch (...) {
+			if (fresh) {
+				_chunks.pop_front();
+				_offset = 0;
+			}
+			throw;
+		}
+		chunk.lo = slot;
+		_offset = slot;
+		++_size;
+	}
+
+	/**
+	 * @throw	std::runtime_error if SnapshotDVector is empty
+	 */
+	void _check() const {
+		if (empty())
+			throw std::runtime_error("vector is empty");
+	}
+}; // SnapshotDVector
@@ -0,0 +1,476 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "cxx17memory"
+
+/**
+ *  structure-of-arrays variant of DVector:
+ *  		every field of the record is stored in its own ring buffer (column),
+ *  		all columns share head, size and capacity cursors
+ *  		columns live in a single allocation, each starting on a cache line,
+ *  		so that scanning one field streams only that field's bytes
+ */
+template <typename... Ts>
+class SoaDVector {
+	static_assert(sizeof...(Ts) > 0, "SoaDVector needs at least one column");
+
+	enum class at {
+		front,
+		back
+	}; // enum class at
+
+	using Columns = std::tuple<Ts*...>;
+	using Indices = std::index_sequence_for<Ts...>;
+
+	static constexpr std::size_t _alignment = 64;
+	static constexpr std::size_t _initial_capacity = 8;
+
+public:
+	using value_type = std::tuple<Ts...>;
+	using reference = std::tuple<Ts&...>;
+	using const_reference = std::tuple<const Ts&...>;
+
+	template <std::size_t I>
+	using column_type = std::tuple_element_t<I, value_type>;
+
+	/**
+	 * 	column view: the ring of one column split into its two contiguous parts
+	 * 		first	elements from the head to the end of storage
+	 * 		second	elements wrapped to the beginning of storage
+	 */
+	template <typename T>
+	struct Segments {
+		std::span<T> first;
+		std::span<T> second;
+	};
+
+	/**
+	 * @brief	constructs empty SoaDVector
+	 * 			does not allocate any space
+	 */
+	SoaDVector() noexcept = default;
+
+	/**
+	 * @brief	constructs SoaDVector as copy of the other one
+	 * 			allocates necessary space only once
+	 * @param 	o 			the other SoaDVector
+	 */
+	SoaDVector(const SoaDVector& o) {
+		reserve(o.size());
+		for (std::size_t i = 0; i < o.size(); ++i)
+			_copy_back(o, i, Indices());
+	}
+
+	/**
+	 * @brief	constructs SoaDVector by stealing storage of the other one
+	 * @param 	o 			the other SoaDVector
+	 */
+	SoaDVector(SoaDVector&& o) noexcept {
+		swap(o);
+	}
+
+	/**
+	 * @brief	copy-assignment operator
+	 * 			uses copy and swap idiom
+	 * @param 	o			the other SoaDVector
+	 * @return 	reference to this instance
+	 */
+	SoaDVector& operator=(const SoaDVector& o) {
+		SoaDVector tmp = o;
+		swap(tmp);
+		return *this;
+	}
+
+	/**
+	 * @brief	move-assignment operator
+	 * @param 	o			the other SoaDVector
+	 * @return 	reference to this instance
+	 */
+	SoaDVector& operator=(SoaDVector&& o) noexcept {
+		SoaDVector tmp = std::move(o);
+		swap(tmp);
+		return *this;
+	}
+
+	/**
+	 * @brief	destructs SoaDVector
+	 */
+	~SoaDVector() {
+		_deallocate();
+	}
+
+	/**
+	 * @brief	appends record, one value per column
+	 * 			can invalidate all column views if reallocation takes place
+	 * @param 	values
+	 */
+	template <typename... Us>
+	void push_back(Us&&... values) {
+		_push(at::back, std::forward<Us>(values)...);
+	}
+
+	/**
+	 * @brief	prepends record, one value per column
+	 * 			can invalidate all column views if reallocation takes place
+	 * @param 	values
+	 */
+	template <typename... Us>
+	void push_front(Us&&... values) {
+		_push(at::front, std::forward<Us>(values)...);
+	}
+
+	/**
+	 * @brief	removes the first record
+	 * @throw	std::runtime_error if SoaDVector is empty
+	 */
+	void pop_front() {
+		_check();
+		_destroy(_head, Indices());
+		_head = (_head + 1) & _mask();
+		--_size;
+	}
+
+	/**
+	 * @brief	removes the last record
+	 * @throw	std::runtime_error if SoaDVector is empty
+	 */
+	void pop_back() {
+		_check();
+		_destroy(_slot(_size - 1), Indices());
+		--_size;
+	}
+
+	/**
+	 * @throw	std::runtime_error if SoaDVector is empty
+	 * @return	tuple of references to fields of the first record
+	 */
+	reference front() {
+		_check();
+		return (*this)[0];
+	}
+	const_reference front() const {
+		_check();
+		return (*this)[0];
+	}
+
+	/**
+	 * @throw	std::runtime_error if SoaDVector is empty
+	 * @return	tuple of references to fields of the last record
+	 */
+	reference back() {
+		_check();
+		return (*this)[_size - 1];
+	}
+	const_reference back() const {
+		_check();
+		return (*this)[_size - 1];
+	}
+
+	/**
+	 * @brief	access record in ix'th position
+	 * 			does no checks whatsoever
+	 * @param 	ix 			position
+	 * @return 	tuple of references to fields of the record
+	 */
+	reference operator[](std::size_t ix) {
+		return _record<reference>(_slot(ix), Indices());
+	}
+	const_reference operator[](std::size_t ix) const {
+		return _record<const_reference>(_slot(ix), Indices());
+	}
+
+	/**
+	 * @brief	access single field of the record in ix'th position
+	 * 			does no checks whatsoever
+	 * @param 	ix 			position
+	 * @return 	reference to the field
+	 */
+	template <std::size_t I>
+	column_type<I>& get(std::size_t ix) {
+		return std::get<I>(_columns)[_slot(ix)];
+	}
+	template <std::size_t I>
+	const column_type<I>& get(std::size_t ix) const {
+		return std::get<I>(_columns)[_slot(ix)];
+	}
+
+	/**
+	 * @brief	contiguous view of one column
+	 * 			invalidated by any reallocation
+	 * @return 	both parts of the column ring in logical order
+	 */
+	template <std::size_t I>
+	Segments<column_type<I>> column() {
+		return _column<column_type<I>>(std::get<I>(_columns));
+	}
+	template <std::size_t I>
+	Segments<const column_type<I>> column() const {
+		return _column<const column_type<I>>(std::get<I>(_columns));
+	}
+
+	/**
+	 * @return	true if SoaDVector is empty, false otherwise
+	 */
+	bool empty() const noexcept {
+		return _size == 0;
+	}
+
+	/**
+	 * @return 	number of stored records
+	 */
+	std::size_t size() const noexcept {
+		return _size;
+	}
+
+	/**
+	 * @return 	number of records which fit into the allocated storage
+	 */
+	std::size_t capacity() const noexcept {
+		return _capacity;
+	}
+
+	/**
+	 * @brief	makes capacity at least n
+	 * 			capacity is always rounded up to the power of two
+	 * @param 	n			new capacity
+	 */
+	void reserve(std::size_t n) {
+		if (n > _capacity) {
+			std::size_t capacity = 1;
+			while (capacity < n)
+				capacity <<= 1;
+			_reallocate(capacity);
+		}
+	}
+
+	/**
+	 * @brief	destroys all records
+	 * 			keeps allocated storage
+	 */
+	void clear() noexcept {
+		while (_size) {
+			_destroy(_slot(_size - 1), Indices());
+			--_size;
+		}
+		_head = 0;
+	}
+
+	/**
+	 * @brief	swaps with the other SoaDVector
+	 * @param 	o 			the other SoaDVector
+	 */
+	void swap(SoaDVector& o) noexcept {
+		using std::swap;
+		swap(_columns, o._columns);
+		swap(_head, o._head);
+		swap(_size, o._size);
+		swap(_capacity, o._capacity);
+	}
+
+private:
+	Columns _columns{};
+	std::size_t _head = 0;
+	std::size_t _size = 0;
+	std::size_t _capacity = 0;
+
+
+	std::size_t _mask() const noexcept {
+		return _capacity - 1;
+	}
+
+	/**
+	 * @brief	storage index of x'th record
+	 * @param 	x
+	 * @return 	index into every column
+	 */
+	std::size_t _slot(std::size_t x) const noexcept {
+		return (_head + x) & _mask();
+	}
+
+	/**
+	 * @brief	offsets of the columns within one allocation for given capacity
+	 * 			every column starts on the cache line boundary
+	 * @param 	capacity
+	 * @param 	offsets		output array of column offsets
+	 * @return 	total number of bytes
+	 */
+	static std::size_t _layout(std::size_t capacity, std::size_t (&offsets)[sizeof...(Ts)]) {
+		constexpr std::size_t sizes[] = { sizeof(Ts)... };
+		std::size_t total = 0;
+		for (std::size_t i = 0; i < sizeof...(Ts); ++i) {
+			offsets[i] = total;
+			total += (capacity * sizes[i] + _alignment - 1) / _alignment * _alignment;
+		}
+		return total;
+	}
+
+	template <std::size_t... I>
+	static Columns _columns_at(std::byte* base, const std::size_t (&offsets)[sizeof...(Ts)],
+							   std::index_sequence<I...>) {
+		return Columns(reinterpret_cast<Ts*>(base + offsets[I])...);
+	}
+
+	template <typename T>
+	Segments<T> _column(T* data) const noexcept {
+		std::size_t tail = _capacity - _head;
+		std::size_t first = _size < tail ? _size : tail;
+		return { std::span<T>(data + _head, first), std::span<T>(data, _size - first) };
+	}
+
+	template <typename Ref, std::size_t... I>
+	Ref _record(std::size_t slot, std::index_sequence<I...>) const {
+		return Ref(std::get<I>(_columns)[slot]...);
+	}
+
+	/**
+	 * @brief	moves all records into freshly allocated storage
+	 * 			elements are stored from the beginning of new storage
+	 * 			columns whose move can throw are copied before the others are moved,
+	 * 			so if relocation throws the new storage is released
+	 * 			and the records stay untouched
+	 * @param 	n			new capacity, has to be a power of two
+	 */
+	void _reallocate(std::size_t n) {
+		std::size_t offsets[sizeof...(Ts)];
+		std::size_t bytes = _layout(n, offsets);
+		std::unique_ptr<std::byte, Release> storage(
+			static_cast<std::byte*>(::operator new(bytes, std::align_val_t(_alignment))));
+		Columns columns = _columns_at(storage.get(), offsets, Indices());
+		_relocate(columns, Indices());
+		std::size_t size = _size;
+		_deallocate();
+		_columns = columns;
+		_head = 0;
+		_size = size;
+		_capacity = n;
+		storage.release();
+	}
+
+	/**
+	 * 	frees storage allocated by _reallocate until it is committed
+	 */
+	struct Release {
+		void operator()(std::byte* base) const noexcept {
+			::operator delete(static_cast<void*>(base), std::align_val_t(_alignment));
+		}
+	};
+
+	/**
+	 * @brief	relocates all columns, destroys the relocated ones if a later one throws
+	 * 			columns which are copied go first, so that no column has been moved
+	 * 			from when a copy throws
+	 */
+	template <std::size_t... I>
+	void _relocate(const Columns& to, std::index_sequence<I...>) {
+		bool done[sizeof...(Ts)] = {};
+		try {
+			((_copied<Ts>() ? (_relocate_column(std::get<I>(to), std::get<I>(_columns)), done[I] = true) : false), ...);
+			((!_copied<Ts>() ? (_relocate_column(std::get<I>(to), std::get<I>(_columns)), done[I] = true) : false), ...);
+		} catch (...) {
+			((done[I] ? void(std::destroy_n(std::get<I>(to), _size)) : void()), ...);
+			throw;
+		}
+	}
+
+	/**
+	 * @return	true if column of T is relocated by copying (its move can throw)
+	 */
+	template <typename T>
+	static constexpr bool _copied() noexcept {
+		return !std::is_nothrow_move_constructible_v<T> && std::is_copy_constructible_v<T>;
+	}
+
+	template <typename T>
+	void _relocate_column(T* to, T* from) {
+		auto segments = _column<T>(from);
+		T* middle = _relocate_segment(segments.first, to);
+		try {
+			_relocate_segment(segments.second, middle);
+		} catch (...) {
+			std::destroy(to, middle);
+			throw;
+		}
+	}
+
+	template <typename T>
+	static T* _relocate_segment(std::span<T> from, T* to) {
+		if constexpr (_copied<T>())
+			return std::uninitialized_copy(from.begin(), from.end(), to);
+		else
+			return std::uninitialized_move(from.begin(), from.end(), to);
+	}
+
+	/**
+	 * @brief	destroys records and frees storage
+	 */
+	void _deallocate() noexcept {
+		if (_capacity) {
+			clear();
+			::operator delete(static_cast<void*>(std::get<0>(_columns)), std::align_val_t(_alignment));
+			_columns = Columns();
+			_capacity = 0;
+		}
+	}
+
+	/**
+	 * @brief	unified push function
+	 * 			constructs fields column by column, already constructed fields
+	 * 			are destroyed if construction of a later one throws
+	 * @param 	where		front/back
+	 * @param 	values		one value per column
+	 */
+	template <typename... Us>
+	void _push(at where, Us&&... values) {
+		static_assert(sizeof...(Us) == sizeof...(Ts), "one value per column is required");
+		if (_size == _capacity)
+			_reallocate(!_capacity ? _initial_capacity : _capacity * 2);
+		std::size_t slot = where == at::front ? (_head - 1) & _mask() : _slot(_size);
+		_construct<0>(slot, std::forward<Us>(values)...);
+		if (where == at::front)
+			_head = slot;
+		++_size;
+	}
+
+	template <std::size_t I, typename U, typename... Us>
+	void _construct(std::size_t slot, U&& value, Us&&... rest) {
+		using T = column_type<I>;
+		T* ptr = std::get<I>(_columns) + slot;
+		new (ptr) T(std::forward<U>(value));
+		if constexpr (sizeof...(Us) > 0) {
+			try {
+				_construct<I + 1>(slot, std::forward<Us>(rest)...);
+			} catch (...) {
+				std::destroy_at(ptr);
+				throw;
+			}
+		}
+	}
+
+	template <std::size_t... I>
+	void _destroy(std::size_t slot, std::index_sequence<I...>) noexcept {
+		(std::destroy_at(std::get<I>(_columns) + slot), ...);
+	}
+
+	template <std::size_t... I>
+	void _copy_back(const SoaDVector& o, std::size_t ix, std::index_sequence<I...>) {
+		push_back(o.template get<I>(ix)...);
+	}
+
+	/**
+	 * @brief	checks if SoaDVector is empty, which is invalid state
+	 * 			to call some of its methods
+	 * @throw	std::runtime_error if SoaDVector is empty
+	 */
+	void _check() const {
+		if (empty())
+			throw std::runtime_error("vector is empty");
+	}
+}; // SoaDVector
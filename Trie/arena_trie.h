@@ -0,0 +1,277 @@
+#ifndef ARENA_TRIE_H
+#define ARENA_TRIE_H
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "key_traits.h"
+
+/**
+ *  Binary Trie whose Nodes live in a single arena:
+ *  		Nodes are addressed by 32-bit indices and take 12 bytes each,
+ *  		values are kept densely in a parallel array,
+ *  		building and destroying the whole Trie costs a few allocations
+ *  		instead of two allocations per stored key
+ */
+template<typename Value, typename KeyTraits = BitSequenceTraits>
+class ArenaTrie {
+	using Seq = typename KeyTraits::key_type;
+	using index_type = std::uint32_t;
+
+	static constexpr index_type _none = 0;     // root is never a child, 0 marks missing child
+	static constexpr index_type _no_value = std::numeric_limits<index_type>::max();
+
+public:
+	using key_type = Seq;
+	using traits_type = KeyTraits;
+
+	/**
+	 * @brief	class representing inner node of ArenaTrie
+	 */
+	struct Node {
+		index_type children[2];
+		index_type value;
+	};
+
+	/**
+	 * @brief default ctor
+	 * 			creates the root
+	 */
+	ArenaTrie() {
+		_nodes.push_back(Node{ { _none, _none }, _no_value });
+	}
+
+	/**
+	 * @return	number of stored values
+	 */
+	std::size_t size() const noexcept {
+		return _values.size();
+	}
+
+	/**
+	 * @return	number of Nodes in use (including the root)
+	 */
+	std::size_t node_count() const noexcept {
+		return _nodes.size() - _free_count;
+	}
+
+	/**
+	 * @brief	preallocates storage
+	 * @param 	nodes		expected number of Nodes
+	 * @param 	values		expected number of values
+	 */
+	void reserve(std::size_t nodes, std::size_t values) {
+		_nodes.reserve(nodes);
+		_values.reserve(values);
+		_owners.reserve(values);
+	}
+
+	/**
+	 * @brief	inserts element to the ArenaTrie
+	 * 			if element is already present insertion will not take a place
+	 * @param 	seq			key
+	 * @param 	val			value to be inserted
+	 * @return	true if insertion succeeds, false otherwise
+	 * @throw	std::length_error if 32-bit indices are exhausted
+	 */
+	bool insert(const Seq& seq, const Value& val) {
+		index_type node = 0;
+		for (std::size_t i = 0, n = KeyTraits::size(seq); i < n; ++i) {
+			bool r = KeyTraits::bit(seq, i);
+			index_type child = _nodes[node].children[r];
+			if (child == _none) {
+				child = _allocate();
+				_nodes[node].children[r] = child;
+			}
+			node = child;
+		}
+		return _store(node, val);
+	}
+
+	/**
+	 * @brief	replaces content of the ArenaTrie by elements of entries
+	 * 			bits of the previous key are kept next to the Nodes on its path,
+	 * 			every key is compared with them to find the shared prefix and
+	 * 			continues from the Node at its end without walking from the root,
+	 * 			Nodes are appended to the arena in depth-first order
+	 * 			unsorted keys are inserted correctly, they only share less of the path
+	 * 			if a key repeats, its first value is kept
+	 * @param 	entries		range of (key, value) pairs sorted by keys
+	 * @return	number of inserted elements
+	 * @throw	std::length_error if 32-bit indices are exhausted
+	 */
+	template< typename Entries >
+	std::size_t build_from_sorted(const Entries& entries) {
+		clear();
+		std::vector<index_type> path{ 0 };
+		std::vector<bool> prev;
+		std::size_t inserted = 0;
+		for (const auto& [seq, val] : entries) {
+			std::size_t n = KeyTraits::size(seq), common = 0;
+			std::size_t shared = n < prev.size() ? n : prev.size();
+			while (common < shared && KeyTraits::bit(seq, common) == prev[common])
+				++common;
+			path.resize(common + 1);
+			prev.resize(n);
+			index_type node = path.back();
+			for (std::size_t i = common; i < n; ++i) {
+				bool r = KeyTraits::bit(seq, i);
+				prev[i] = r;
+				index_type child = _nodes[node].children[r];
+				if (child == _none) {
+					child = _allocate();
+					_nodes[node].children[r] = child;
+				}
+				node = child;
+				path.push_back(node);
+			}
+			inserted += _store(node, val);
+		}
+		return inserted;
+	}
+
+	/**
+	 * @brief	searches for value
+	 * @param 	seq			key
+	 * @return 	const raw pointer to the value, nullptr if value is not present
+	 */
+	const Value* search(const Seq& seq) const noexcept {
+		index_type node = _search(seq);
+		if (node == _none && KeyTraits::size(seq))
+			return nullptr;
+		index_type value = _nodes[node].value;
+		return value == _no_value ? nullptr : &_values[value];
+	}
+
+	/**
+	 * @brief	searches for value
+	 * @param 	seq			key
+	 * @return 	raw pointer to the value, nullptr if value is not present
+	 */
+	Value* search(const Seq& seq) noexcept {
+		return const_cast<Value*>(const_cast<const ArenaTrie*>(this)->search(seq));
+	}
+
+	/**
+	 * @brief	removes element
+	 * 			moves the last value into the freed slot and returns Nodes
+	 * 			which are left empty on the key's path to the free list
+	 * @param 	seq 		key
+	 * @return 	true if element was present, false otherwise
+	 */
+	bool remove(const Seq& seq) {
+		std::size_t n = KeyTraits::size(seq);
+		_path.clear();
+		index_type node = 0;
+		for (std::size_t i = 0; i < n; ++i) {
+			_path.push_back(node);
+			node = _nodes[node].children[KeyTraits::bit(seq, i)];
+			if (node == _none)
+				return false;
+		}
+		index_type value = _nodes[node].value;
+		if (value == _no_value)
+			return false;
+		_nodes[node].value = _no_value;
+		if (value + 1 != _values.size()) {
+			_values[value] = std::move(_values.back());
+			_owners[value] = _owners.back();
+			_nodes[_owners[value]].value = value;
+		}
+		_values.pop_back();
+		_owners.pop_back();
+
+		for (std::size_t i = n; i > 0 && _is_leaf(node); --i) {
+			index_type parent = _path[i - 1];
+			_nodes[parent].children[KeyTraits::bit(seq, i - 1)] = _none;
+			_release(node);
+			node = parent;
+		}
+		return true;
+	}
+
+	/**
+	 * @brief	removes all elements
+	 * 			keeps allocated storage, Nodes are not freed one by one
+	 */
+	void clear() noexcept {
+		_nodes.resize(1);
+		_nodes[0] = Node{ { _none, _none }, _no_value };
+		_values.clear();
+		_owners.clear();
+		_free = _none;
+		_free_count = 0;
+	}
+
+private:
+	std::vector<Node> _nodes;
+	std::vector<Value> _values;
+	std::vector<index_type> _owners;        // Node holding the value at the same position
+	std::vector<index_type> _path;          // scratch buffer used by remove
+	index_type _free = _none;               // free list linked through children[0]
+	std::size_t _free_count = 0;
+
+	/**
+	 * @brief	gets a Node from the free list or the end of the arena
+	 * @return 	index of an empty Node
+	 */
+	index_type _allocate() {
+		if (_free != _none) {
+			index_type node = _free;
+			_free = _nodes[node].children[0];
+			--_free_count;
+			_nodes[node] = Node{ { _none, _none }, _no_value };
+			return node;
+		}
+		if (_nodes.size() > std::numeric_limits<index_type>::max() - 1)
+			throw std::length_error("ArenaTrie is full");
+		_nodes.push_back(Node{ { _none, _none }, _no_value });
+		return index_type(_nodes.size() - 1);
+	}
+
+	/**
+	 * @brief	stores value in Node unless it already holds one
+	 * @return	true if value was stored, false otherwise
+	 */
+	bool _store(index_type node, const Value& val) {
+		if (_nodes[node].value != _no_value)
+			return false;
+		if (_values.size() == _no_value)
+			throw std::length_error("ArenaTrie is full");
+		_values.push_back(val);
+		_owners.push_back(node);
+		_nodes[node].value = index_type(_values.size() - 1);
+		return true;
+	}
+
+	void _release(index_type node) noexcept {
+		_nodes[node].children[0] = _free;
+		_free = node;
+		++_free_count;
+	}
+
+	bool _is_leaf(index_type node) const noexcept {
+		const Node& n = _nodes[node];
+		return n.value == _no_value && n.children[0] == _none && n.children[1] == _none;
+	}
+
+	/**
+	 * @brief	searches for Node at provided key
+	 * @return	index of the Node, _none if it is not present
+	 * 			(0 is returned for the empty key, which is the root)
+	 */
+	index_type _search(const Seq& seq) const noexcept {
+		index_type node = 0;
+		for (std::size_t i = 0, n = KeyTraits::size(seq); i < n; ++i) {
+			node = _nodes[node].children[KeyTraits::bit(seq, i)];
+			if (node == _none)
+				return _none;
+		}
+		return node;
+	}
+};
+
+#endif
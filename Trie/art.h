@@ -0,0 +1,705 @@
+#ifndef ART_H
+#define ART_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined( __SSE2__ )
+#include <emmintrin.h>
+#endif
+
+/**
+ *  Adaptive Radix Tree over byte keys:
+ *  		every inner Node consumes one byte of the key and grows or shrinks
+ *  		between four layouts according to the number of children:
+ *  			Node4		up to 4 sorted keys and children
+ *  			Node16		up to 16 sorted keys searched by a single SSE2 compare
+ *  			Node48		256-entry index into 48 children
+ *  			Node256		child pointer for every byte
+ *  		path compression: inner Node stores the bytes shared by all keys below it,
+ *  		lazy expansion: a key is kept in a Leaf as high in the tree as it is unique,
+ *  		inner Nodes are created only where keys branch
+ *  		keys which are prefixes of other keys are stored as terminal Leaf of the Node
+ *  		where they end
+ */
+template<typename Value>
+class Art {
+	enum class Kind : std::uint8_t {
+		leaf,
+		node4,
+		node16,
+		node48,
+		node256
+	}; // enum class Kind
+
+	struct Node {
+		Kind kind;
+
+		explicit Node(Kind kind) noexcept
+				: kind(kind) {}
+	};
+
+	struct Leaf : Node {
+		std::string key;
+		Value value;
+
+		Leaf(std::string_view key, const Value& value)
+				: Node(Kind::leaf),
+				  key(key),
+				  value(value) {}
+	};
+
+	/**
+	 * 	header shared by all inner Nodes, Nodes do not own anything,
+	 * 	children and terminal are released by Art
+	 */
+	struct Inner : Node {
+		std::uint16_t count = 0;
+		std::string prefix;             // compressed bytes preceding the branching byte
+		Leaf* terminal = nullptr;       // key which ends in this Node
+
+		using Node::Node;
+	};
+
+	struct Node4 : Inner {
+		static constexpr std::size_t capacity = 4;
+		std::uint8_t keys[4];
+		Node* children[4];
+
+		Node4() noexcept
+				: Inner(Kind::node4) {}
+	};
+
+	struct Node16 : Inner {
+		static constexpr std::size_t capacity = 16;
+		alignas(16) std::uint8_t keys[16];
+		Node* children[16];
+
+		Node16() noexcept
+				: Inner(Kind::node16) {}
+	};
+
+	struct Node48 : Inner {
+		static constexpr std::size_t capacity = 48;
+		std::uint8_t index[256] = {};   // slot + 1 of the child, 0 if there is none
+		Node* children[48] = {};
+
+		Node48() noexcept
+				: Inner(Kind::node48) {}
+	};
+
+	struct Node256 : Inner {
+		static constexpr std::size_t capacity = 256;
+		Node* children[256] = {};
+
+		Node256() noexcept
+				: Inner(Kind::node256) {}
+	};
+
+public:
+	using key_type = std::string;
+
+	/**
+	 * @brief default ctor
+	 */
+	Art() = default;
+
+	/**
+	 * @brief	copy ctor
+	 * @param 	other		instance of Art class
+	 */
+	Art(const Art& other)
+			: Art() {
+		other.for_each([this](const std::string& key, const Value& value) {
+			insert(key, value);
+		});
+	}
+
+	/**
+	 * @brief	move ctor
+	 * @param 	other		instance of Art class, left empty
+	 */
+	Art(Art&& other) noexcept
+			: _root(std::exchange(other._root, nullptr)),
+			  _size(std::exchange(other._size, 0)) {}
+
+	Art& operator=(Art other) noexcept {
+		std::swap(_root, other._root);
+		std::swap(_size, other._size);
+		return *this;
+	}
+
+	~Art() {
+		_clear();
+	}
+
+	/**
+	 * @return	number of stored values
+	 */
+	std::size_t size() const noexcept {
+		return _size;
+	}
+
+	/**
+	 * @brief	inserts element to the Art
+	 * 			if element is already present insertion will not take a place
+	 * @param 	key			key
+	 * @param 	val			value to be inserted
+	 * @return	true if insertion succeeds, false otherwise
+	 */
+	bool insert(std::string_view key, const Value& val) {
+		Node** ref = &_root;
+		std::size_t depth = 0;
+		for (;;) {
+			Node* node = *ref;
+			if (!node) {
+				*ref = new Leaf(key, val);
+				break;
+			}
+			if (node->kind == Kind::leaf) {
+				Leaf* leaf = static_cast<Leaf*>(node);
+				if (leaf->key == key)
+					return false;
+				_split_leaf(ref, leaf, key, val, depth);
+				break;
+			}
+			Inner* inner = static_cast<Inner*>(node);
+			std::size_t common = _common(inner->prefix, key, depth);
+			if (common < inner->prefix.size()) {
+				_split_prefix(ref, inner, common, key, val, depth);
+				break;
+			}
+			depth += common;
+			if (depth == key.size()) {
+				if (inner->terminal)
+					return false;
+				inner->terminal = new Leaf(key, val);
+				break;
+			}
+			std::uint8_t byte = key[depth];
+			Node** child = _find_child(inner, byte);
+			if (!child) {
+				Leaf* leaf = new Leaf(key, val);
+				try {
+					_add_child(ref, byte, leaf);
+				} catch (...) {
+					delete leaf;
+					throw;
+				}
+				break;
+			}
+			ref = child;
+			++depth;
+		}
+		++_size;
+		return true;
+	}
+
+	/**
+	 * @brief	searches for value
+	 * @param 	key			key
+	 * @return 	const raw pointer to the value, nullptr if value is not present
+	 */
+	const Value* search(std::string_view key) const noexcept {
+		const Node* node = _root;
+		std::size_t depth = 0;
+		while (node) {
+			if (node->kind == Kind::leaf) {
+				const Leaf* leaf = static_cast<const Leaf*>(node);
+				return leaf->key == key ? &leaf->value : nullptr;
+			}
+			const Inner* inner = static_cast<const Inner*>(node);
+			if (_common(inner->prefix, key, depth) < inner->prefix.size())
+				return nullptr;
+			depth += inner->prefix.size();
+			if (depth == key.size())
+				return inner->terminal ? &inner->terminal->value : nullptr;
+			Node* const* child = _find_child(const_cast<Inner*>(inner), key[depth]);
+			if (!child)
+				return nullptr;
+			node = *child;
+			++depth;
+		}
+		return nullptr;
+	}
+
+	/**
+	 * @brief	searches for value
+	 * @param 	key			key
+	 * @return 	raw pointer to the value, nullptr if value is not present
+	 */
+	Value* search(std::string_view key) noexcept {
+		return const_cast<Value*>(const_cast<const Art*>(this)->search(key));
+	}
+
+	/**
+	 * @brief	removes element
+	 * 			shrinks the Node which loses a child and merges it into its
+	 * 			only remaining child or Leaf
+	 * @param 	key 		key
+	 * @return 	true if element was present, false otherwise
+	 */
+	bool remove(std::string_view key) {
+		Node** ref = &_root;
+		Node** parent = nullptr;        // slot of the inner Node owning *ref
+		std::size_t depth = 0;
+		while (Node* node = *ref) {
+			if (node->kind == Kind::leaf) {
+				Leaf* leaf = static_cast<Leaf*>(node);
+				if (leaf->key != key)
+					return false;
+				if (parent) {
+					_remove_child(parent, std::uint8_t(key[depth - 1]));
+				} else {
+					*ref = nullptr;
+				}
+				delete leaf;
+				--_size;
+				return true;
+			}
+			Inner* inner = static_cast<Inner*>(node);
+			if (_common(inner->prefix, key, depth) < inner->prefix.size())
+				return false;
+			depth += inner->prefix.size();
+			if (depth == key.size()) {
+				if (!inner->terminal)
+					return false;
+				delete inner->terminal;
+				inner->terminal = nullptr;
+				_compact(ref);
+				--_size;
+				return true;
+			}
+			Node** child = _find_child(inner, key[depth]);
+			if (!child)
+				return false;
+			parent = ref;
+			ref = child;
+			++depth;
+		}
+		return false;
+	}
+
+	/**
+	 * @brief	unites two Arts
+	 * @param 	other 		other Art
+	 * @param 	zip 		function objects to zip values
+	 */
+	template< typename Zip >
+	void uniteWith(const Art& other, Zip zip) {
+		other.for_each([this, &zip](const std::string& key, const Value& value) {
+			if (Value* own = search(key))
+				*own = zip(*own, value);
+			else
+				insert(key, value);
+		});
+	}
+
+	/**
+	 * @brief	calls f on every element in lexicographic order of keys
+	 * @param 	f			function object taking (const std::string& key, const Value& value)
+	 */
+	template< typename F >
+	void for_each(F f) const {
+		if (!_root)
+			return;
+		std::vector<const Node*> stack{ _root };
+		std::vector<const Node*> children;
+		while (!stack.empty()) {
+			const Node* node = stack.back();
+			stack.pop_back();
+			if (node->kind == Kind::leaf) {
+				const Leaf* leaf = static_cast<const Leaf*>(node);
+				f(leaf->key, leaf->value);
+				continue;
+			}
+			const Inner* inner = static_cast<const Inner*>(node);
+			children.clear();
+			_for_children(const_cast<Inner*>(inner), [&children](std::uint8_t, Node*& child) {
+				children.push_back(child);
+			});
+			stack.insert(stack.end(), children.rbegin(), children.rend());
+			if (inner->terminal)
+				stack.push_back(inner->terminal);
+		}
+	}
+
+private:
+	Node* _root = nullptr;
+	std::size_t _size = 0;
+
+
+	/**
+	 * @return	number of bytes of prefix matching key from depth
+	 */
+	static std::size_t _common(std::string_view prefix, std::string_view key, std::size_t depth) noexcept {
+		std::size_t i = 0, n = std::min(prefix.size(), key.size() - depth);
+		while (i < n && prefix[i] == key[depth + i])
+			++i;
+		return i;
+	}
+
+	/**
+	 * @brief	calls f(byte, child slot) on every child in byte order
+	 */
+	template <typename F>
+	static void _for_children(Inner* inner, F f) {
+		switch (inner->kind) {
+		case Kind::node4: {
+			auto* n = static_cast<Node4*>(inner);
+			for (std::size_t i = 0; i < n->count; ++i)
+				f(n->keys[i], n->children[i]);
+			break;
+		}
+		case Kind::node16: {
+			auto* n = static_cast<Node16*>(inner);
+			for (std::size_t i = 0; i < n->count; ++i)
+				f(n->keys[i], n->children[i]);
+			break;
+		}
+		case Kind::node48: {
+			auto* n = static_cast<Node48*>(inner);
+			for (std::size_t b = 0; b < 256; ++b) {
+				if (n->index[b])
+					f(std::uint8_t(b), n->children[n->index[b] - 1]);
+			}
+			break;
+		}
+		case Kind::node256: {
+			auto* n = static_cast<Node256*>(inner);
+			for (std::size_t b = 0; b < 256; ++b) {
+				if (n->children[b])
+					f(std::uint8_t(b), n->children[b]);
+			}
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	/**
+	 * @return	slot of the child for byte, nullptr if there is none
+	 */
+	static Node** _find_child(Inner* inner, std::uint8_t byte) noexcept {
+		switch (inner->kind) {
+		case Kind::node4: {
+			auto* n = static_cast<Node4*>(inner);
+			for (std::size_t i = 0; i < n->count; ++i) {
+				if (n->keys[i] == byte)
+					return &n->children[i];
+			}
+			return nullptr;
+		}
+		case Kind::node16: {
+			auto* n = static_cast<Node16*>(inner);
+#if defined( __SSE2__ )
+			__m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8(char(byte)), _mm_load_si128(reinterpret_cast<const __m128i*>(n->keys)));
+			unsigned mask = unsigned(_mm_movemask_epi8(cmp)) & ((1u << n->count) - 1);
+			return mask ? &n->children[__builtin_ctz(mask)] : nullptr;
+#else
+			for (std::size_t i = 0; i < n->count; ++i) {
+				if (n->keys[i] == byte)
+					return &n->children[i];
+			}
+			return nullptr;
+#endif
+		}
+		case Kind::node48: {
+			auto* n = static_cast<Node48*>(inner);
+			return n->index[byte] ? &n->children[n->index[byte] - 1] : nullptr;
+		}
+		case Kind::node256: {
+			auto* n = static_cast<Node256*>(inner);
+			return n->children[byte] ? &n->children[byte] : nullptr;
+		}
+		default:
+			return nullptr;
+		}
+	}
+
+	static std::size_t _capacity(const Inner* inner) noexcept {
+		switch (inner->kind) {
+		case Kind::node4:
+			return Node4::capacity;
+		case Kind::node16:
+			return Node16::capacity;
+		case Kind::node48:
+			return Node48::capacity;
+		default:
+			return Node256::capacity;
+		}
+	}
+
+	/**
+	 * @brief	adds child to Node which has free capacity
+	 * 			keys of Node4 and Node16 are kept sorted
+	 */
+	static void _insert_child(Inner* inner, std::uint8_t byte, Node* child) noexcept {
+		auto sorted = [&](std::uint8_t* keys, Node** children) {
+			std::size_t pos = 0;
+			while (pos < inner->count && keys[pos] < byte)
+				++pos;
+			std::memmove(keys + pos + 1, keys + pos, inner->count - pos);
+			std::memmove(children + pos + 1, children + pos, (inner->count - pos) * sizeof(Node*));
+			keys[pos] = byte;
+			children[pos] = child;
+		};
+		switch (inner->kind) {
+		case Kind::node4:
+			sorted(static_cast<Node4*>(inner)->keys, static_cast<Node4*>(inner)->children);
+			break;
+		case Kind::node16:
+			sorted(static_cast<Node16*>(inner)->keys, static_cast<Node16*>(inner)->children);
+			break;
+		case Kind::node48: {
+			auto* n = static_cast<Node48*>(inner);
+			std::size_t slot = 0;
+			while (n->children[slot])
+				++slot;
+			n->children[slot] = child;
+			n->index[byte] = std::uint8_t(slot + 1);
+			break;
+		}
+		default:
+			static_cast<Node256*>(inner)->children[byte] = child;
+			break;
+		}
+		++inner->count;
+	}
+
+	/**
+	 * @brief	removes child for byte from Node
+	 */
+	static void _erase_child(Inner* inner, std::uint8_t byte) noexcept {
+		auto sorted = [&](std::uint8_t* keys, Node** children) {
+			std::size_t pos = 0;
+			while (keys[pos] != byte)
+				++pos;
+			std::memmove(keys + pos, keys + pos + 1, inner->count - pos - 1);
+			std::memmove(children + pos, children + pos + 1, (inner->count - pos - 1) * sizeof(Node*));
+		};
+		switch (inner->kind) {
+		case Kind::node4:
+			sorted(static_cast<Node4*>(inner)->keys, static_cast<Node4*>(inner)->children);
+			break;
+		case Kind::node16:
+			sorted(static_cast<Node16*>(inner)->keys, static_cast<Node16*>(inner)->children);
+			break;
+		case Kind::node48: {
+			auto* n = static_cast<Node48*>(inner);
+			n->children[n->index[byte] - 1] = nullptr;
+			n->index[byte] = 0;
+			break;
+		}
+		default:
+			static_cast<Node256*>(inner)->children[byte] = nullptr;
+			break;
+		}
+		--inner->count;
+	}
+
+	static Inner* _make_inner(Kind kind) {
+		switch (kind) {
+		case Kind::node4:
+			return new Node4;
+		case Kind::node16:
+			return new Node16;
+		case Kind::node48:
+			return new Node48;
+		default:
+			return new Node256;
+		}
+	}
+
+	/**
+	 * @brief	deletes single Node, its children and terminal are left intact
+	 */
+	static void _delete_node(Node* node) noexcept {
+		switch (node->kind) {
+		case Kind::leaf:
+			delete static_cast<Leaf*>(node);
+			break;
+		case Kind::node4:
+			delete static_cast<Node4*>(node);
+			break;
+		case Kind::node16:
+			delete static_cast<Node16*>(node);
+			break;
+		case Kind::node48:
+			delete static_cast<Node48*>(node);
+			break;
+		case Kind::node256:
+			delete static_cast<Node256*>(node);
+			break;
+		}
+	}
+
+	/**
+	 * @brief	replaces Node in its slot by Node of another kind with the same content
+	 * @param 	ref			slot of the Node
+	 * @param 	kind		new kind, has to be able to hold all children
+	 */
+	static void _convert(Node** ref, Kind kind) {
+		Inner* old = static_cast<Inner*>(*ref);
+		Inner* inner = _make_inner(kind);
+		inner->prefix = std::move(old->prefix);
+		inner->terminal = old->terminal;
+		_for_children(old, [inner](std::uint8_t byte, Node*& child) {
+			_insert_child(inner, byte, child);
+		});
+		*ref = inner;
+		_delete_node(old);
+	}
+
+	/**
+	 * @brief	adds child, grows the Node if it is full
+	 */
+	static void _add_child(Node** ref, std::uint8_t byte, Node* child) {
+		Inner* inner = static_cast<Inner*>(*ref);
+		if (inner->count == _capacity(inner))
+			_convert(ref, Kind(std::uint8_t(inner->kind) + 1));
+		_insert_child(static_cast<Inner*>(*ref), byte, child);
+	}
+
+	/**
+	 * @brief	removes child and compacts the Node
+	 */
+	static void _remove_child(Node** ref, std::uint8_t byte) {
+		_erase_child(static_cast<Inner*>(*ref), byte);
+		_compact(ref);
+	}
+
+	/**
+	 * @brief	restores invariants of the Node after it lost a child or terminal:
+	 * 			Node with terminal only is replaced by the terminal Leaf,
+	 * 			Node with single child and no terminal is merged into the child,
+	 * 			Node which is mostly empty is shrunk
+	 * 			(shrinking is skipped if memory cannot be allocated)
+	 * @param 	ref			slot of the Node
+	 */
+	static void _compact(Node** ref) {
+		Inner* inner = static_cast<Inner*>(*ref);
+		if (inner->count == 0) {
+			*ref = inner->terminal;
+			_delete_node(inner);
+			return;
+		}
+		if (inner->count == 1 && !inner->terminal) {
+			std::uint8_t byte = 0;
+			Node* child = nullptr;
+			_for_children(inner, [&](std::uint8_t b, Node*& c) {
+				byte = b;
+				child = c;
+			});
+			if (child->kind != Kind::leaf) {
+				Inner* below = static_cast<Inner*>(child);
+				below->prefix = inner->prefix + char(byte) + below->prefix;
+			}
+			*ref = child;
+			_delete_node(inner);
+			return;
+		}
+		static constexpr std::size_t shrink_at[] = { 0, 0, 3, 12, 37 };
+		if (inner->count <= shrink_at[std::size_t(inner->kind)]) {
+			try {
+				_convert(ref, Kind(std::uint8_t(inner->kind) - 1));
+			} catch (const std::bad_alloc&) {}
+		}
+	}
+
+	/**
+	 * @brief	replaces Leaf by Node4 holding the Leaf and the new key
+	 * @param 	ref			slot of the Leaf
+	 * @param 	leaf		Leaf in the slot, its key differs from key
+	 * @param 	key			new key
+	 * @param 	val			new value
+	 * @param 	depth		number of bytes consumed above the slot
+	 */
+	static void _split_leaf(Node** ref, Leaf* leaf, std::string_view key, const Value& val, std::size_t depth) {
+		std::string_view rest = std::string_view(leaf->key).substr(depth);
+		std::size_t common = _common(rest, key, depth);
+		Node4* inner = new Node4;
+		Leaf* added = nullptr;
+		try {
+			inner->prefix.assign(key.substr(depth, common));
+			added = new Leaf(key, val);
+		} catch (...) {
+			delete inner;
+			throw;
+		}
+		depth += common;
+		_place(inner, leaf, depth);
+		_place(inner, added, depth);
+		*ref = inner;
+	}
+
+	/**
+	 * @brief	splits compressed prefix of Node by a new Node4
+	 * @param 	ref			slot of the Node
+	 * @param 	inner		Node in the slot
+	 * @param 	common		number of matching bytes of the prefix, less than its size
+	 * @param 	key			new key
+	 * @param 	val			new value
+	 * @param 	depth		number of bytes consumed above the slot
+	 */
+	static void _split_prefix(Node** ref, Inner* inner, std::size_t common, std::string_view key, const Value& val, std::size_t depth) {
+		Node4* parent = new Node4;
+		Leaf* added = nullptr;
+		try {
+			parent->prefix.assign(inner->prefix, 0, common);
+			added = new Leaf(key, val);
+		} catch (...) {
+			delete parent;
+			throw;
+		}
+		std::uint8_t byte = inner->prefix[common];
+		inner->prefix.erase(0, common + 1);
+		_insert_child(parent, byte, inner);
+		_place(parent, added, depth + common);
+		*ref = parent;
+	}
+
+	/**
+	 * @brief	puts Leaf under Node4 which has free capacity
+	 * @param 	depth		number of bytes consumed by the Node4 and its ancestors
+	 */
+	static void _place(Node4* inner, Leaf* leaf, std::size_t depth) noexcept {
+		if (leaf->key.size() == depth)
+			inner->terminal = leaf;
+		else
+			_insert_child(inner, std::uint8_t(leaf->key[depth]), leaf);
+	}
+
+	/**
+	 * @brief	releases all Nodes without recursion
+	 */
+	void _clear() noexcept {
+		if (!_root)
+			return;
+		std::vector<Node*> stack{ _root };
+		while (!stack.empty()) {
+			Node* node = stack.back();
+			stack.pop_back();
+			if (node->kind != Kind::leaf) {
+				Inner* inner = static_cast<Inner*>(node);
+				_for_children(inner, [&stack](std::uint8_t, Node*& child) {
+					stack.push_back(child);
+				});
+				if (inner->terminal)
+					stack.push_back(inner->terminal);
+			}
+			_delete_node(node);
+		}
+		_root = nullptr;
+		_size = 0;
+	}
+};
+
+#endif
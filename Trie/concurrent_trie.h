@@ -0,0 +1,392 @@
+#ifndef CONCURRENT_TRIE_H
+#define CONCURRENT_TRIE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "key_traits.h"
+
+namespace detail {
+
+	/**
+	 * @brief	index of the calling thread among the threads reading a ConcurrentTrie
+	 * 			taken on the first call, given back when the thread exits,
+	 * 			the lowest free index is taken, so indices stay small
+	 */
+	class ReaderIndex {
+	public:
+		static std::size_t current() {
+			thread_local ReaderIndex index;
+			return index._value;
+		}
+
+	private:
+		std::size_t _value;
+
+		ReaderIndex() {
+			std::lock_guard<std::mutex> lock(_mutex());
+			std::vector<bool>& taken = _taken();
+			_value = 0;
+			while (_value < taken.size() && taken[_value])
+				++_value;
+			if (_value == taken.size())
+				taken.push_back(true);
+			else
+				taken[_value] = true;
+		}
+
+		~ReaderIndex() {
+			std::lock_guard<std::mutex> lock(_mutex());
+			_taken()[_value] = false;
+		}
+
+		static std::mutex& _mutex() {
+			static std::mutex mutex;
+			return mutex;
+		}
+
+		static std::vector<bool>& _taken() {
+			static std::vector<bool> taken;
+			return taken;
+		}
+	};
+
+} // namespace detail
+
+/**
+ *  binary Trie for many concurrent readers and serialized writers (RCU-style):
+ *  		published Nodes are never modified, insert and remove copy the Nodes
+ *  		on the key's path, link them to the untouched subtrees
+ *  		and publish the new root by a single atomic store,
+ *  		readers walk the version they have loaded without any lock or retry
+ *  	replaced Nodes are reclaimed by epochs: every reader announces the epoch
+ *  	it has started in and a Node retired in epoch e is freed once no reader
+ *  	announces epoch e or older
+ *  	each of the first 128 reading threads owns a slot for its epoch,
+ *  	further threads share a few spare slots
+ */
+template<typename Value, typename KeyTraits = BitSequenceTraits>
+class ConcurrentTrie {
+	using Seq = typename KeyTraits::key_type;
+
+	static constexpr std::size_t _slot_count = 128;     // slots owned by one thread each
+	static constexpr std::size_t _spare_count = 8;      // slots shared by the other threads
+
+	/**
+	 * 	immutable once published
+	 */
+	struct Node {
+		Node* children[2] = { nullptr, nullptr };
+		std::optional<Value> value;
+	};
+
+	/**
+	 * 	epoch announced by one reader, 0 if no reader uses the slot
+	 */
+	struct alignas(64) Slot {
+		std::atomic<std::uint64_t> epoch{ 0 };
+	};
+
+	struct Retired {
+		std::uint64_t epoch;
+		Node* node;
+	};
+
+public:
+	using key_type = Seq;
+	using traits_type = KeyTraits;
+
+	/**
+	 * 	keeps the version loaded by a reader alive, taken by pin()
+	 */
+	class Guard {
+	public:
+		Guard(const Guard&) = delete;
+		Guard& operator=(const Guard&) = delete;
+
+		~Guard() {
+			if (!_slot)
+				return;
+			if (_spare) {
+				std::vector<const Slot*>& held = _held_spares();
+				held.erase(std::find(held.begin(), held.end(), _slot));
+			}
+			_slot->epoch.store(0, std::memory_order_release);
+		}
+
+	private:
+		friend class ConcurrentTrie;
+		Slot* _slot;                // nullptr if an outer Guard of the thread holds the slot
+		bool _spare;
+
+		explicit Guard(Slot* slot, bool spare = false) noexcept
+				: _slot(slot), _spare(spare) {}
+	};
+
+	/**
+	 * @brief default ctor
+	 */
+	ConcurrentTrie()
+			: _root(new Node) {}
+
+	ConcurrentTrie(const ConcurrentTrie&) = delete;
+	ConcurrentTrie& operator=(const ConcurrentTrie&) = delete;
+
+	/**
+	 * @brief	dtor
+	 * 			no reader may be running
+	 */
+	~ConcurrentTrie() {
+		for (const Retired& r : _retired)
+			delete r.node;
+		std::vector<Node*> stack{ _root.load(std::memory_order_relaxed) };
+		while (!stack.empty()) {
+			Node* node = stack.back();
+			stack.pop_back();
+			for (Node* child : node->children) {
+				if (child)
+					stack.push_back(child);
+			}
+			delete node;
+		}
+	}
+
+	/**
+	 * @brief	announces a reader, Nodes it can reach are not freed until the Guard is destroyed
+	 * 			wait-free for a thread which owns a slot: a single store of the epoch,
+	 * 			Guards may nest, the outermost one keeps the epoch,
+	 * 			threads beyond the first 128 share spare slots and spin while all are taken,
+	 * 			spare slots they hold are recorded per thread, so nested Guards do not take another
+	 * @return 	Guard of the current epoch
+	 */
+	Guard pin() const {
+		std::size_t index = detail::ReaderIndex::current();
+		if (index < _slot_count) {
+			Slot& slot = _slots[index];
+			if (slot.epoch.load(std::memory_order_relaxed))
+				return Guard(nullptr);
+			slot.epoch.store(_epoch.load());
+			return Guard(&slot);
+		}
+		std::vector<const Slot*>& held = _held_spares();
+		std::less<const Slot*> less;
+		for (const Slot* slot : held) {
+			if (!less(slot, _slots + _slot_count) && less(slot, _slots + _slot_count + _spare_count))
+				return Guard(nullptr);
+		}
+		held.reserve(held.size() + 1);      // push_back below cannot throw with the slot taken
+		for (std::size_t i = index;; ++i) {
+			Slot& slot = _slots[_slot_count + i % _spare_count];
+			std::uint64_t expected = 0;
+			if (slot.epoch.load(std::memory_order_relaxed) == 0
+				&& slot.epoch.compare_exchange_strong(expected, _epoch.load())) {
+				held.push_back(&slot);
+				return Guard(&slot, true);
+			}
+		}
+	}
+
+	/**
+	 * @brief	searches for value
+	 * @param 	seq			key
+	 * @return 	copy of the value, empty if value is not present
+	 */
+	std::optional<Value> search(const Seq& seq) const {
+		Guard guard = pin();
+		const Node* node = _find(seq);
+		return node ? node->value : std::nullopt;
+	}
+
+	/**
+	 * @brief	calls f on the value while the version is pinned
+	 * @param 	seq			key
+	 * @param 	f			function object taking const Value&
+	 * @return	true if value is present, false otherwise
+	 */
+	template< typename F >
+	bool visit(const Seq& seq, F f) const {
+		Guard guard = pin();
+		const Node* node = _find(seq);
+		if (!node || !node->value)
+			return false;
+		f(*node->value);
+		return true;
+	}
+
+	/**
+	 * @return	number of stored values
+	 */
+	std::size_t size() const noexcept {
+		return _size.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief	inserts element, copies the Nodes on the key's path
+	 * 			if element is already present insertion will not take a place
+	 * @param 	seq			key
+	 * @param 	val			value to be inserted
+	 * @return	true if insertion succeeds, false otherwise
+	 */
+	bool insert(const Seq& seq, const Value& val) {
+		std::lock_guard<std::mutex> lock(_writer);
+		Node* old = _root.load(std::memory_order_relaxed);
+		std::size_t n = KeyTraits::size(seq);
+		const Node* found = _find(old, seq);
+		if (found && found->value)
+			return false;
+
+		std::vector<Node*> replaced{ old };
+		std::vector<Node*> copies;
+		copies.reserve(n + 1);               // push_back cannot throw and leak the new Node
+		try {
+			copies.push_back(new Node(*old));
+			for (std::size_t i = 0; i < n; ++i) {
+				Node*& child = copies.back()->children[KeyTraits::bit(seq, i)];
+				if (child) {
+					copies.push_back(new Node(*child));
+					replaced.push_back(child);
+				} else {
+					copies.push_back(new Node);
+				}
+				child = copies.back();
+			}
+			copies.back()->value.emplace(val);
+		} catch (...) {
+			for (Node* copy : copies)
+				delete copy;
+			throw;
+		}
+		_publish(copies.front(), replaced);
+		_size.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	/**
+	 * @brief	removes element, copies the Nodes on the key's path
+	 * 			down to the topmost Node which stays
+	 * @param 	seq 		key
+	 * @return 	true if element was present, false otherwise
+	 */
+	bool remove(const Seq& seq) {
+		std::lock_guard<std::mutex> lock(_writer);
+		Node* old = _root.load(std::memory_order_relaxed);
+		std::size_t n = KeyTraits::size(seq);
+		std::vector<Node*> replaced{ old };
+		std::size_t cut = 0;             // depth of the Node whose child gets unlinked
+		for (std::size_t i = 0; i < n; ++i) {
+			Node* node = replaced.back();
+			if (node->value || (node->children[0] && node->children[1]))
+				cut = i;
+			Node* child = node->children[KeyTraits::bit(seq, i)];
+			if (!child)
+				return false;
+			replaced.push_back(child);
+		}
+		Node* target = replaced.back();
+		if (!target->value)
+			return false;
+		bool prune = n && !target->children[0] && !target->children[1];
+		std::size_t depth = prune ? cut : n;   // last copied depth
+
+		std::vector<Node*> copies;
+		copies.reserve(depth + 1);           // push_back cannot throw and leak the new Node
+		try {
+			copies.push_back(new Node(*old));
+			for (std::size_t i = 0; i < depth; ++i) {
+				Node*& child = copies.back()->children[KeyTraits::bit(seq, i)];
+				copies.push_back(new Node(*child));
+				child = copies.back();
+			}
+		} catch (...) {
+			for (Node* copy : copies)
+				delete copy;
+			throw;
+		}
+		if (prune)
+			copies.back()->children[KeyTraits::bit(seq, depth)] = nullptr;
+		else
+			copies.back()->value.reset();
+		_publish(copies.front(), replaced);
+		_size.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	/**
+	 * @brief	frees retired Nodes which no reader can reach any more
+	 * 			called by every update, can be called again once readers leave
+	 */
+	void reclaim() {
+		std::lock_guard<std::mutex> lock(_writer);
+		_reclaim();
+	}
+
+	/**
+	 * @return	number of retired Nodes waiting to be freed
+	 */
+	std::size_t pending() const {
+		std::lock_guard<std::mutex> lock(_writer);
+		return _retired.size();
+	}
+
+private:
+	std::atomic<Node*> _root;
+	std::atomic<std::uint64_t> _epoch{ 1 };
+	std::atomic<std::size_t> _size{ 0 };
+	mutable Slot _slots[_slot_count + _spare_count];
+	mutable std::mutex _writer;
+	std::deque<Retired> _retired;
+
+
+	/**
+	 * @return	spare slots (of any ConcurrentTrie of this type) held by the calling thread
+	 */
+	static std::vector<const Slot*>& _held_spares() {
+		thread_local std::vector<const Slot*> held;
+		return held;
+	}
+
+	const Node* _find(const Seq& seq) const noexcept {
+		return _find(_root.load(), seq);
+	}
+
+	static const Node* _find(const Node* node, const Seq& seq) noexcept {
+		for (std::size_t i = 0, n = KeyTraits::size(seq); node && i < n; ++i)
+			node = node->children[KeyTraits::bit(seq, i)];
+		return node;
+	}
+
+	/**
+	 * @brief	publishes new root and retires replaced Nodes
+	 * 			Nodes are tagged by the epoch current after publication,
+	 * 			readers which started later cannot reach them
+	 */
+	void _publish(Node* root, const std::vector<Node*>& replaced) {
+		_root.store(root);
+		std::uint64_t epoch = _epoch.fetch_add(1);
+		for (Node* node : replaced)
+			_retired.push_back(Retired{ epoch, node });
+		_reclaim();
+	}
+
+	void _reclaim() noexcept {
+		std::uint64_t oldest = _epoch.load();
+		for (const Slot& slot : _slots) {
+			std::uint64_t e = slot.epoch.load();
+			if (e && e < oldest)
+				oldest = e;
+		}
+		while (!_retired.empty() && _retired.front().epoch < oldest) {
+			delete _retired.front().node;
+			_retired.pop_front();
+		}
+	}
+};
+
+#endif
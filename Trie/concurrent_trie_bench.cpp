@@ -0,0 +1,114 @@
+// mixed read/write benchmark of ConcurrentTrie against Trie guarded by std::shared_mutex
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include "concurrent_trie.h"
+#include "trie.h"
+
+using Key = std::uint32_t;
+using Traits = IntegerKeyTraits<Key>;
+
+static constexpr std::size_t key_count = 1 << 20;
+static constexpr auto duration = std::chrono::milliseconds(500);
+
+static std::atomic<std::uint64_t> found{ 0 };     // keeps lookups from being optimized out
+
+struct LockedTrie {
+	Trie<Key, Traits> trie;
+	mutable std::shared_mutex mutex;
+
+	bool search(Key key) const {
+		std::shared_lock<std::shared_mutex> lock(mutex);
+		return trie.search(key);
+	}
+	void insert(Key key) {
+		std::unique_lock<std::shared_mutex> lock(mutex);
+		trie.insert(key, key);
+	}
+	void remove(Key key) {
+		std::unique_lock<std::shared_mutex> lock(mutex);
+		trie.remove(key);
+	}
+};
+
+struct RcuTrie {
+	ConcurrentTrie<Key, Traits> trie;
+
+	bool search(Key key) const {
+		return bool(trie.search(key));
+	}
+	void insert(Key key) {
+		trie.insert(key, key);
+	}
+	void remove(Key key) {
+		trie.remove(key);
+	}
+};
+
+/**
+ * @brief	runs readers on all but one thread and a writer which keeps
+ * 			inserting and removing keys
+ * @return 	lookups per second
+ */
+template <typename T>
+double run(T& t, const std::vector<Key>& keys, unsigned readers) {
+	std::atomic<bool> stop{ false };
+	std::atomic<std::uint64_t> lookups{ 0 };
+	std::vector<std::thread> threads;
+	for (unsigned r = 0; r < readers; ++r) {
+		threads.emplace_back([&, r] {
+			std::uint64_t done = 0, hits = 0;
+			for (std::size_t i = r * 7919; !stop.load(std::memory_order_relaxed); ++i, ++done)
+				hits += t.search(keys[i % keys.size()]);
+			lookups += done;
+			found += hits;
+		});
+	}
+	std::thread writer([&] {
+		std::mt19937 gen(1);
+		while (!stop.load(std::memory_order_relaxed)) {
+			Key key = keys[gen() % keys.size()];
+			t.remove(key);
+			t.insert(key);
+		}
+	});
+	std::this_thread::sleep_for(duration);
+	stop = true;
+	writer.join();
+	for (auto& thread : threads)
+		thread.join();
+	return lookups / std::chrono::duration<double>(duration).count();
+}
+
+int main() {
+	std::mt19937 gen(0);
+	std::vector<Key> keys(key_count);
+	for (auto& key : keys)
+		key = gen();
+
+	LockedTrie locked;
+	RcuTrie rcu;
+	for (Key key : keys) {
+		locked.insert(key);
+		rcu.insert(key);
+	}
+
+	unsigned cores = std::thread::hardware_concurrency();
+	unsigned max_readers = cores > 1 ? cores - 1 : 1;      // one core is left to the writer
+	std::printf("%8s %16s %16s\n", "readers", "shared_mutex", "ConcurrentTrie");
+	for (unsigned readers = 1;; readers = readers * 2 < max_readers ? readers * 2 : max_readers) {
+		double a = run(locked, keys, readers);
+		double b = run(rcu, keys, readers);
+		std::printf("%8u %13.2f M/s %13.2f M/s\n", readers, a / 1e6, b / 1e6);
+		if (readers == max_readers)
+			break;
+	}
+	return 0;
+}
@@ -0,0 +1,182 @@
+#ifndef FROZEN_TRIE_H
+#define FROZEN_TRIE_H
+
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+#include "trie.h"
+
+namespace detail {
+
+	/**
+	 * @brief	append-only bit vector with constant time rank
+	 * 			number of set bits preceding every 512-bit block is kept
+	 * 			in 32 bits, which adds 6.25 % to the bits themselves
+	 */
+	class RankBitVector {
+	public:
+		void push_back(bool b) {
+			if ((_size & 511) == 0)
+				_blocks.push_back(_ones);
+			if ((_size & 63) == 0)
+				_words.push_back(0);
+			if (b) {
+				_words.back() |= std::uint64_t(1) << (_size & 63);
+				++_ones;
+			}
+			++_size;
+		}
+
+		bool operator[](std::size_t i) const noexcept {
+			return (_words[i >> 6] >> (i & 63)) & 1;
+		}
+
+		/**
+		 * @param 	i			position, has to be less than size()
+		 * @return 	number of set bits before position i
+		 */
+		std::size_t rank(std::size_t i) const noexcept {
+			std::size_t r = _blocks[i >> 9];
+			for (std::size_t w = (i >> 9) << 3; w < (i >> 6); ++w)
+				r += std::popcount(_words[w]);
+			if (i & 63)
+				r += std::popcount(_words[i >> 6] & ((std::uint64_t(1) << (i & 63)) - 1));
+			return r;
+		}
+
+		std::size_t size() const noexcept {
+			return _size;
+		}
+
+		/**
+		 * @return	bytes occupied by bits and block counts
+		 */
+		std::size_t memory_usage() const noexcept {
+			return _words.capacity() * sizeof(std::uint64_t) + _blocks.capacity() * sizeof(std::uint32_t);
+		}
+
+		void shrink_to_fit() {
+			_words.shrink_to_fit();
+			_blocks.shrink_to_fit();
+		}
+
+	private:
+		std::vector<std::uint64_t> _words;
+		std::vector<std::uint32_t> _blocks;
+		std::size_t _size = 0;
+		std::uint32_t _ones = 0;
+	};
+
+} // namespace detail
+
+/**
+ *  immutable succinct (LOUDS) form of the binary Trie:
+ *  		Nodes are numbered in level order, the root is 0
+ *  		Node i is described by bits 2i (has left child) and 2i + 1 (has right child)
+ *  		of _children, child at set bit p is Node rank(p) + 1,
+ *  		bit i of _has_value marks Nodes holding value and rank(i) is index of
+ *  		the value in the packed array
+ *  	three bits per Node (plus rank blocks) replace three pointers
+ *  	created by Trie::freeze()
+ */
+template<typename Value, typename KeyTraits>
+class FrozenTrie {
+	using Seq = typename KeyTraits::key_type;
+public:
+	using key_type = Seq;
+	using traits_type = KeyTraits;
+	using Match = typename Trie<Value, KeyTraits>::Match;
+
+	/**
+	 * @brief	encodes the Trie
+	 * @param 	trie
+	 */
+	explicit FrozenTrie(const Trie<Value, KeyTraits>& trie) {
+		using Node = typename Trie<Value, KeyTraits>::Node;
+		std::vector<const Node*> queue{ &trie.root() };
+		for (std::size_t i = 0; i < queue.size(); ++i) {
+			const Node* node = queue[i];
+			_children.push_back(node->left());
+			_children.push_back(node->right());
+			_has_value.push_back(node->value());
+			if (node->left())
+				queue.push_back(node->left());
+			if (node->right())
+				queue.push_back(node->right());
+			if (node->value())
+				_values.push_back(*node->value());
+		}
+		_children.shrink_to_fit();
+		_has_value.shrink_to_fit();
+		_values.shrink_to_fit();
+	}
+
+	/**
+	 * @brief	searches for value
+	 * @param 	seq			key
+	 * @return 	const raw pointer to the value, nullptr if value is not present
+	 */
+	const Value* search(const Seq& seq) const noexcept {
+		std::size_t node = 0;
+		for (std::size_t i = 0, n = KeyTraits::size(seq); i < n; ++i) {
+			std::size_t pos = 2 * node + KeyTraits::bit(seq, i);
+			if (!_children[pos])
+				return nullptr;
+			node = _children.rank(pos) + 1;
+		}
+		return _value(node);
+	}
+
+	/**
+	 * @brief	finds the longest prefix of key which holds value
+	 * @param 	seq			key
+	 * @return 	value of the deepest Node on the key's path and its depth
+	 */
+	Match longest_prefix_match(const Seq& seq) const noexcept {
+		std::size_t node = 0;
+		Match match{ _value(node), 0 };
+		for (std::size_t i = 0, n = KeyTraits::size(seq); i < n; ++i) {
+			std::size_t pos = 2 * node + KeyTraits::bit(seq, i);
+			if (!_children[pos])
+				break;
+			node = _children.rank(pos) + 1;
+			if (_has_value[node])
+				match = Match{ _value(node), i + 1 };
+		}
+		return match;
+	}
+
+	/**
+	 * @return	number of stored values
+	 */
+	std::size_t size() const noexcept {
+		return _values.size();
+	}
+
+	/**
+	 * @return	number of Nodes (including the root)
+	 */
+	std::size_t node_count() const noexcept {
+		return _has_value.size();
+	}
+
+	/**
+	 * @return	bytes occupied by the structure and the values (not counting
+	 * 			memory owned by values themselves)
+	 */
+	std::size_t memory_usage() const noexcept {
+		return _children.memory_usage() + _has_value.memory_usage() + _values.capacity() * sizeof(Value);
+	}
+
+private:
+	detail::RankBitVector _children;
+	detail::RankBitVector _has_value;
+	std::vector<Value> _values;
+
+	const Value* _value(std::size_t node) const noexcept {
+		return _has_value[node] ? &_values[_has_value.rank(node)] : nullptr;
+	}
+};
+
+#endif
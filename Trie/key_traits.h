@@ -0,0 +1,146 @@
+#ifndef TRIE_KEY_TRAITS_H
+#define TRIE_KEY_TRAITS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+/**
+ *  KeyTraits describe how Trie reads bits of its keys:
+ *  		key_type							type of the key
+ *  		static std::size_t size(key)		number of bits of the key
+ *  		static bool bit(key, i)				i'th bit of the key, 0 is the first one
+ *  	bits are read directly from the key, nothing has to be allocated per lookup
+ */
+
+/**
+ * @brief	traits for std::vector<bool> (default key type of Trie)
+ */
+struct BitSequenceTraits {
+	using key_type = std::vector<bool>;
+
+	static std::size_t size(const key_type& key) noexcept {
+		return key.size();
+	}
+
+	static bool bit(const key_type& key, std::size_t i) noexcept {
+		return key[i];
+	}
+};
+
+/**
+ * @brief	unsigned 128-bit integer (e.g. IPv6 address)
+ */
+struct Uint128 {
+	std::uint64_t hi = 0;
+	std::uint64_t lo = 0;
+
+	friend bool operator==(const Uint128& a, const Uint128& b) noexcept {
+		return a.hi == b.hi && a.lo == b.lo;
+	}
+	friend bool operator!=(const Uint128& a, const Uint128& b) noexcept {
+		return !(a == b);
+	}
+};
+
+using Ipv6Address = Uint128;
+
+namespace detail {
+
+	template <typename UInt>
+	struct IntegerBits {
+		static_assert(std::is_unsigned<UInt>::value, "key has to be unsigned integer");
+		static constexpr std::size_t width = std::numeric_limits<UInt>::digits;
+
+		static bool msb(UInt value, std::size_t i) noexcept {
+			return (value >> (width - 1 - i)) & 1;
+		}
+	};
+
+	template <>
+	struct IntegerBits<Uint128> {
+		static constexpr std::size_t width = 128;
+
+		static bool msb(const Uint128& value, std::size_t i) noexcept {
+			return i < 64 ? (value.hi >> (63 - i)) & 1 : (value.lo >> (127 - i)) & 1;
+		}
+	};
+
+} // namespace detail
+
+/**
+ * @brief	traits for fixed-width unsigned integer keys
+ * 			bits are read from the most significant one by shifts
+ */
+template <typename UInt>
+struct IntegerKeyTraits {
+	using key_type = UInt;
+
+	static constexpr std::size_t size(const key_type&) noexcept {
+		return detail::IntegerBits<UInt>::width;
+	}
+
+	static bool bit(const key_type& key, std::size_t i) noexcept {
+		return detail::IntegerBits<UInt>::msb(key, i);
+	}
+};
+
+/**
+ * @brief	the first length most significant bits of an unsigned integer
+ * 			(e.g. network prefix), implicitly constructible from a whole integer
+ */
+template <typename UInt>
+struct BitPrefix {
+	UInt bits{};
+	std::size_t length = detail::IntegerBits<UInt>::width;
+
+	BitPrefix() = default;
+
+	BitPrefix(const UInt& bits, std::size_t length = detail::IntegerBits<UInt>::width) noexcept
+			: bits(bits),
+			  length(length) {}
+};
+
+/**
+ * @brief	traits for BitPrefix keys
+ */
+template <typename UInt>
+struct PrefixKeyTraits {
+	using key_type = BitPrefix<UInt>;
+
+	static std::size_t size(const key_type& key) noexcept {
+		return key.length;
+	}
+
+	static bool bit(const key_type& key, std::size_t i) noexcept {
+		return detail::IntegerBits<UInt>::msb(key.bits, i);
+	}
+};
+
+/**
+ * @brief	non-owning view of length bits stored in bytes
+ * 			bits are taken from the most significant bit of the first byte
+ */
+struct BitSpan {
+	const std::uint8_t* data = nullptr;
+	std::size_t length = 0;
+};
+
+/**
+ * @brief	traits for BitSpan keys
+ */
+struct BitSpanTraits {
+	using key_type = BitSpan;
+
+	static std::size_t size(const key_type& key) noexcept {
+		return key.length;
+	}
+
+	static bool bit(const key_type& key, std::size_t i) noexcept {
+		return (key.data[i >> 3] >> (7 - (i & 7))) & 1;
+	}
+};
+
+#endif
@@ -0,0 +1,289 @@
+#ifndef MAPPED_TRIE_H
+#define MAPPED_TRIE_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "trie.h"
+
+/**
+ *  read-only view of a Trie stored in a flat file (POSIX only):
+ *  		file starts with a 64-byte header, followed by the Nodes in level order
+ *  		and by the values,
+ *  		Nodes refer to their children by index, so the file does not depend
+ *  		on the address it is mapped at and is queried directly from the mapping,
+ *  		opening costs one mmap and one pass over the Nodes which checks their
+ *  		indices, the pages are shared by all processes which map the same file
+ *  	the file is written by MappedTrie::save, integers are stored in host byte order
+ *  	(file of different byte order is rejected by the magic number)
+ */
+template<typename Value, typename KeyTraits = BitSequenceTraits>
+class MappedTrie {
+	static_assert(std::is_trivially_copyable<Value>::value, "values are stored as raw bytes");
+	static_assert(alignof(Value) <= 64, "padding before values is written from 64-byte buffer");
+
+	using Seq = typename KeyTraits::key_type;
+	using index_type = std::uint32_t;
+
+	static constexpr index_type _none = 0;     // root is never a child, 0 marks missing child
+	static constexpr index_type _no_value = std::numeric_limits<index_type>::max();
+
+	struct Header {
+		std::uint64_t magic;
+		std::uint32_t version;
+		std::uint32_t value_size;
+		std::uint64_t node_count;
+		std::uint64_t value_count;
+		std::uint64_t nodes_offset;
+		std::uint64_t values_offset;
+	};
+
+	/**
+	 * 	Node as stored in the file (12 bytes)
+	 */
+	struct Node {
+		index_type children[2];
+		index_type value;
+	};
+
+	static constexpr std::uint64_t _magic = 0x31454952544c4654ull;  // "TFLTRIE1"
+	static constexpr std::uint32_t _version = 1;
+	static constexpr std::size_t _nodes_offset = 64;
+
+	static_assert(sizeof(Header) <= _nodes_offset, "header does not fit");
+	static_assert(sizeof(Node) == 12, "Node has to be packed");
+
+public:
+	using key_type = Seq;
+	using traits_type = KeyTraits;
+	using Match = typename Trie<Value, KeyTraits>::Match;
+
+	/**
+	 * @brief	writes the Trie into a file
+	 * 			the file is written under a temporary name and then renamed,
+	 * 			so processes which have the old file mapped keep reading it
+	 * @param 	trie
+	 * @param 	path		path to the file
+	 * @throw	std::system_error if the file cannot be written
+	 * @throw	std::length_error if the Trie does not fit into 32-bit indices
+	 */
+	static void save(const Trie<Value, KeyTraits>& trie, const std::string& path) {
+		using TrieNode = typename Trie<Value, KeyTraits>::Node;
+		std::vector<const TrieNode*> queue{ &trie.root() };
+		std::vector<Node> nodes;
+		std::vector<Value> values;
+		for (std::size_t i = 0; i < queue.size(); ++i) {
+			const TrieNode* node = queue[i];
+			Node out{ { _none, _none }, _no_value };
+			const TrieNode* children[2] = { node->left(), node->right() };
+			for (int b = 0; b < 2; ++b) {
+				if (!children[b])
+					continue;
+				if (queue.size() >= _no_value)
+					throw std::length_error("Trie is too large for MappedTrie");
+				out.children[b] = index_type(queue.size());
+				queue.push_back(children[b]);
+			}
+			if (node->value()) {
+				out.value = index_type(values.size());
+				values.push_back(*node->value());
+			}
+			nodes.push_back(out);
+		}
+
+		std::uint64_t values_offset = _align(_nodes_offset + nodes.size() * sizeof(Node), alignof(Value));
+		Header header{ _magic, _version, sizeof(Value), nodes.size(), values.size(), _nodes_offset, values_offset };
+
+		std::string tmp = path + ".tmp";
+		int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0)
+			_fail("open");
+		try {
+			char padding[64] = {};
+			_write(fd, &header, sizeof(header));
+			_write(fd, padding, _nodes_offset - sizeof(header));
+			_write(fd, nodes.data(), nodes.size() * sizeof(Node));
+			_write(fd, padding, values_offset - _nodes_offset - nodes.size() * sizeof(Node));
+			_write(fd, values.data(), values.size() * sizeof(Value));
+			if (::fsync(fd) < 0)
+				_fail("fsync");
+		} catch (...) {
+			::close(fd);
+			::unlink(tmp.c_str());
+			throw;
+		}
+		::close(fd);
+		if (::rename(tmp.c_str(), path.c_str()) < 0) {
+			int err = errno;
+			::unlink(tmp.c_str());
+			throw std::system_error(err, std::generic_category(), "rename");
+		}
+	}
+
+	/**
+	 * @brief	maps Trie stored in the file
+	 * 			the header and indices in all Nodes are checked, so queries
+	 * 			never leave the mapping even if the file was damaged
+	 * @param 	path		path to the file
+	 * @throw	std::system_error if the file cannot be opened or mapped
+	 * @throw	std::runtime_error if the file does not contain a compatible Trie
+	 */
+	explicit MappedTrie(const std::string& path) {
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			_fail("open");
+		struct stat st;
+		if (::fstat(fd, &st) < 0) {
+			::close(fd);
+			_fail("fstat");
+		}
+		if (std::size_t(st.st_size) < _nodes_offset) {
+			::close(fd);
+			throw std::runtime_error("file does not contain MappedTrie");
+		}
+		void* addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		::close(fd);                            // mapping keeps the file open
+		if (addr == MAP_FAILED)
+			_fail("mmap");
+		_header = static_cast<const Header*>(addr);
+		_length = st.st_size;
+		_nodes = reinterpret_cast<const Node*>(_base() + _header->nodes_offset);
+		_values = reinterpret_cast<const Value*>(_base() + _header->values_offset);
+		try {
+			_validate();
+		} catch (...) {
+			::munmap(addr, _length);
+			throw;
+		}
+	}
+
+	MappedTrie(const MappedTrie&) = delete;
+	MappedTrie& operator=(const MappedTrie&) = delete;
+
+	~MappedTrie() {
+		::munmap(const_cast<Header*>(_header), _length);
+	}
+
+	/**
+	 * @brief	searches for value
+	 * @param 	seq			key
+	 * @return 	const raw pointer into the mapping, nullptr if value is not present
+	 */
+	const Value* search(const Seq& seq) const noexcept {
+		index_type node = 0;
+		for (std::size_t i = 0, n = KeyTraits::size(seq); i < n; ++i) {
+			node = _nodes[node].children[KeyTraits::bit(seq, i)];
+			if (node == _none)
+				return nullptr;
+		}
+		return _value(node);
+	}
+
+	/**
+	 * @brief	finds the longest prefix of key which holds value
+	 * @param 	seq			key
+	 * @return 	value of the deepest Node on the key's path and its depth
+	 */
+	Match longest_prefix_match(const Seq& seq) const noexcept {
+		index_type node = 0;
+		Match match{ _value(node), 0 };
+		for (std::size_t i = 0, n = KeyTraits::size(seq); i < n; ++i) {
+			node = _nodes[node].children[KeyTraits::bit(seq, i)];
+			if (node == _none)
+				break;
+			if (_nodes[node].value != _no_value)
+				match = Match{ _value(node), i + 1 };
+		}
+		return match;
+	}
+
+	/**
+	 * @return	number of stored values
+	 */
+	std::size_t size() const noexcept {
+		return _header->value_count;
+	}
+
+	/**
+	 * @return	number of Nodes (including the root)
+	 */
+	std::size_t node_count() const noexcept {
+		return _header->node_count;
+	}
+
+private:
+	const Header* _header = nullptr;
+	std::size_t _length = 0;
+	const Node* _nodes = nullptr;
+	const Value* _values = nullptr;
+
+
+	static std::uint64_t _align(std::uint64_t offset, std::size_t alignment) noexcept {
+		return (offset + alignment - 1) / alignment * alignment;
+	}
+
+	[[noreturn]] static void _fail(const char* what) {
+		throw std::system_error(errno, std::generic_category(), what);
+	}
+
+	static void _write(int fd, const void* data, std::size_t length) {
+		const char* p = static_cast<const char*>(data);
+		while (length) {
+			ssize_t written = ::write(fd, p, length);
+			if (written < 0) {
+				if (errno == EINTR)
+					continue;
+				_fail("write");
+			}
+			p += written;
+			length -= written;
+		}
+	}
+
+	const char* _base() const noexcept {
+		return reinterpret_cast<const char*>(_header);
+	}
+
+	const Value* _value(index_type node) const noexcept {
+		index_type value = _nodes[node].value;
+		return value == _no_value ? nullptr : &_values[value];
+	}
+
+	/**
+	 * @brief	checks that the mapped file holds Trie of this type
+	 * 			and that every child and value index points inside the file
+	 * @throw	std::runtime_error if it does not
+	 */
+	void _validate() const {
+		if (_header->magic != _magic || _header->version != _version)
+			throw std::runtime_error("file does not contain MappedTrie");
+		if (_header->value_size != sizeof(Value))
+			throw std::runtime_error("MappedTrie value size mismatch");
+		const Header& h = *_header;
+		if (h.node_count == 0 || h.node_count > _no_value || h.value_count > h.node_count
+			|| h.nodes_offset != _nodes_offset || h.values_offset % alignof(Value)
+			|| h.values_offset < h.nodes_offset + h.node_count * sizeof(Node)
+			|| _length < h.values_offset || (_length - h.values_offset) / sizeof(Value) < h.value_count)
+			throw std::runtime_error("MappedTrie header is corrupted");
+		for (std::size_t i = 0; i < h.node_count; ++i) {
+			const Node& node = _nodes[i];
+			if (node.children[0] >= h.node_count || node.children[1] >= h.node_count
+				|| (node.value >= h.value_count && node.value != _no_value))
+				throw std::runtime_error("MappedTrie Node is corrupted");
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,408 @@
+#ifndef PATRICIA_TRIE_H
+#define PATRICIA_TRIE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "key_traits.h"
+
+/**
+ *  path-compressed (Patricia/radix) variant of the binary Trie:
+ *  		every edge is labelled by a whole segment of bits instead of a single bit,
+ *  		nodes exist only where a value is stored or where the keys branch,
+ *  		thus n keys need at most 2n - 1 nodes
+ */
+template<typename Value, typename KeyTraits = BitSequenceTraits>
+class PatriciaTrie {
+	using Seq = typename KeyTraits::key_type;
+public:
+	using key_type = Seq;
+	using traits_type = KeyTraits;
+
+	/**
+	 * @brief	class representing bit segment on an edge
+	 * 			segments of up to 64 bits are stored inline
+	 */
+	class Label {
+	public:
+		Label() = default;
+
+		/**
+		 * @brief	copies bits [from, to) of the key
+		 */
+		Label(const Seq& seq, std::size_t from, std::size_t to) {
+			_resize(to - from);
+			for (std::size_t i = from; i < to; ++i)
+				_set(i - from, KeyTraits::bit(seq, i));
+		}
+
+		Label(const Label& o) {
+			_resize(o._size);
+			std::copy(o._words(), o._words() + _word_count(), _words());
+		}
+
+		Label(Label&& o) noexcept
+				: _size(o._size),
+				  _inline(o._inline),
+				  _heap(std::move(o._heap)) {
+			o._size = 0;
+		}
+
+		Label& operator=(Label o) noexcept {
+			std::swap(_size, o._size);
+			std::swap(_inline, o._inline);
+			std::swap(_heap, o._heap);
+			return *this;
+		}
+
+		/**
+		 * @return	number of bits
+		 */
+		std::size_t size() const noexcept {
+			return _size;
+		}
+
+		/**
+		 * @return 	i'th bit of the segment
+		 */
+		bool bit(std::size_t i) const noexcept {
+			return (_words()[i >> 6] >> (i & 63)) & 1;
+		}
+
+		/**
+		 * @brief	copies bits [from, to) of the segment
+		 */
+		Label slice(std::size_t from, std::size_t to) const {
+			Label l;
+			l._resize(to - from);
+			for (std::size_t i = from; i < to; ++i)
+				l._set(i - from, bit(i));
+			return l;
+		}
+
+		/**
+		 * @brief	concatenates two segments
+		 */
+		static Label concat(const Label& a, const Label& b) {
+			Label l;
+			l._resize(a._size + b._size);
+			for (std::size_t i = 0; i < a._size; ++i)
+				l._set(i, a.bit(i));
+			for (std::size_t i = 0; i < b._size; ++i)
+				l._set(a._size + i, b.bit(i));
+			return l;
+		}
+
+	private:
+		std::size_t _size = 0;
+		std::uint64_t _inline = 0;
+		std::unique_ptr<std::uint64_t[]> _heap;
+
+		std::size_t _word_count() const noexcept {
+			return (_size + 63) >> 6;
+		}
+
+		std::uint64_t* _words() noexcept {
+			return _heap ? _heap.get() : &_inline;
+		}
+		const std::uint64_t* _words() const noexcept {
+			return _heap ? _heap.get() : &_inline;
+		}
+
+		void _resize(std::size_t n) {
+			_size = n;
+			if (n > 64)
+				_heap = std::make_unique<std::uint64_t[]>(_word_count());
+		}
+
+		void _set(std::size_t i, bool b) noexcept {
+			if (b)
+				_words()[i >> 6] |= std::uint64_t(1) << (i & 63);
+		}
+	};
+
+	/**
+	 * @brief	class representing node of PatriciaTrie
+	 */
+	class Node {
+	public:
+		/**
+		 * @brief	label getter
+		 * @return 	segment of bits on the edge leading to this Node
+		 */
+		const Label& label() const noexcept {
+			return _label;
+		}
+
+		/**
+		 * @brief	child getter
+		 * @param 	bit			first bit of the child's label
+		 * @return 	raw pointer to the child Node (nullptr if there is none)
+		 */
+		const Node* child(bool bit) const noexcept {
+			return _children[bit].get();
+		}
+
+		/**
+		 * @brief	value getter
+		 * @return 	raw pointer to the saved value (nullptr if no value is present)
+		 */
+		const Value* value() const noexcept {
+			return _value.get();
+		}
+
+	private:
+		friend class PatriciaTrie;
+		Label _label;
+		std::unique_ptr<Value> _value;
+		std::unique_ptr<Node> _children[2];
+
+		int _child_count() const noexcept {
+			return bool(_children[0]) + bool(_children[1]);
+		}
+	};
+
+	/**
+	 * @brief default ctor
+	 */
+	PatriciaTrie() = default;
+
+	/**
+	 * @brief	copy ctor
+	 * @param 	other		instance of PatriciaTrie class
+	 */
+	PatriciaTrie(const PatriciaTrie& other)
+			: _size(other._size) {
+		_copy(_root.get(), other._root.get());
+	}
+
+	/**
+	 * @brief	dtor
+	 * 			destroys Nodes without recursion, so nested keys cannot overflow the stack
+	 */
+	~PatriciaTrie() {
+		_destroy(_root);
+	}
+
+	/**
+	 * @brief	root getter
+	 * @return	returns const reference to the root (its label is always empty)
+	 */
+	const Node& root() const noexcept {
+		return *_root;
+	}
+
+	/**
+	 * @return	number of stored values
+	 */
+	std::size_t size() const noexcept {
+		return _size;
+	}
+
+	/**
+	 * @brief	inserts element to the PatriciaTrie
+	 * 			if element is already present insertion will not take a place
+	 * 			splits at most one edge
+	 * @param 	seq			key
+	 * @param 	val			value to be inserted
+	 * @return	true if insertion succeeds, false otherwise
+	 */
+	bool insert(const Seq& seq, const Value& val) {
+		Node* node = _root.get();
+		std::size_t pos = 0, n = KeyTraits::size(seq);
+		while (pos < n) {
+			std::unique_ptr<Node>& slot = node->_children[KeyTraits::bit(seq, pos)];
+			if (!slot) {
+				slot = _make_node(Label(seq, pos, n));
+				node = slot.get();
+				pos = n;
+				break;
+			}
+			const Label& label = slot->_label;
+			std::size_t common = _common(label, seq, pos, n);
+			if (common < label.size()) {     // split the edge
+				auto mid = _make_node(label.slice(0, common));
+				slot->_label = label.slice(common, label.size());
+				bool old_bit = slot->_label.bit(0);
+				mid->_children[old_bit] = std::move(slot);
+				slot = std::move(mid);
+			}
+			node = slot.get();
+			pos += common;
+		}
+		if (node->_value)
+			return false;
+		node->_value = std::make_unique<Value>(val);
+		++_size;
+		return true;
+	}
+
+	/**
+	 * @brief	searches for value
+	 * 			compares whole edge segments, depth is bounded by number of branchings
+	 * @param 	seq			key
+	 * @return 	const raw pointer to the value, nullptr if value is not present
+	 */
+	const Value* search(const Seq& seq) const noexcept {
+		const Node* node = _root.get();
+		std::size_t pos = 0, n = KeyTraits::size(seq);
+		while (pos < n) {
+			node = node->child(KeyTraits::bit(seq, pos));
+			if (!node)
+				return nullptr;
+			const Label& label = node->label();
+			if (label.size() > n - pos || _common(label, seq, pos, n) < label.size())
+				return nullptr;
+			pos += label.size();
+		}
+		return node->value();
+	}
+
+	/**
+	 * @brief	searches for value
+	 * @param 	seq			key
+	 * @return 	raw pointer to the value, nullptr if value is not present
+	 */
+	Value* search(const Seq& seq) noexcept {
+		return const_cast<Value*>(const_cast<const PatriciaTrie*>(this)->search(seq));
+	}
+
+	/**
+	 * @brief	removes element
+	 * 			merges Nodes which are left with single child and no value
+	 * @param 	seq 		key
+	 * @return 	true if element was present, false otherwise
+	 */
+	bool remove(const Seq& seq) {
+		std::unique_ptr<Node>* parent_slot = nullptr;
+		std::unique_ptr<Node>* slot = &_root;
+		std::size_t pos = 0, n = KeyTraits::size(seq);
+		while (pos < n) {
+			std::unique_ptr<Node>* next = &(*slot)->_children[KeyTraits::bit(seq, pos)];
+			if (!*next)
+				return false;
+			const Label& label = (*next)->_label;
+			if (label.size() > n - pos || _common(label, seq, pos, n) < label.size())
+				return false;
+			pos += label.size();
+			parent_slot = slot;
+			slot = next;
+		}
+		Node* node = slot->get();
+		if (!node->_value)
+			return false;
+		node->_value.reset();
+		--_size;
+		if (!parent_slot)
+			return true;                // root is never removed nor merged
+		if (node->_child_count() == 0) {
+			slot->reset();
+			_merge(*parent_slot, parent_slot == &_root);
+		} else {
+			_merge(*slot, false);
+		}
+		return true;
+	}
+
+	/**
+	 * @brief	counts Nodes (including the root)
+	 * @return 	number of Nodes
+	 */
+	std::size_t node_count() const {
+		return _count(_root.get());
+	}
+
+private:
+	std::unique_ptr<Node> _root = std::make_unique<Node>();
+	std::size_t _size = 0;
+
+	static std::unique_ptr<Node> _make_node(Label label) {
+		auto node = std::make_unique<Node>();
+		node->_label = std::move(label);
+		return node;
+	}
+
+	/**
+	 * @brief	length of the common prefix of label and bits [pos, n) of the key
+	 */
+	static std::size_t _common(const Label& label, const Seq& seq, std::size_t pos, std::size_t n) noexcept {
+		std::size_t i = 0, len = label.size() < n - pos ? label.size() : n - pos;
+		while (i < len && label.bit(i) == KeyTraits::bit(seq, pos + i))
+			++i;
+		return i;
+	}
+
+	/**
+	 * @brief	merges Node without value and with single child into that child
+	 * @param 	slot		owner of the Node
+	 * @param 	is_root		root is never merged
+	 */
+	static void _merge(std::unique_ptr<Node>& slot, bool is_root) {
+		Node* node = slot.get();
+		if (is_root || node->_value || node->_child_count() != 1)
+			return;
+		std::unique_ptr<Node> child = std::move(node->_children[0] ? node->_children[0] : node->_children[1]);
+		child->_label = Label::concat(node->_label, child->_label);
+		slot = std::move(child);
+	}
+
+	/**
+	 * @brief	copies Nodes below from to to, walks with an explicit stack
+	 * 			(used by copy ctor)
+	 */
+	void _copy(Node* to, const Node* from) {
+		std::vector<std::pair<Node*, const Node*>> stack{ { to, from } };
+		while (!stack.empty()) {
+			auto [dst, src] = stack.back();
+			stack.pop_back();
+			if (src->value())
+				dst->_value = std::make_unique<Value>(*src->value());
+			for (int b = 0; b < 2; ++b) {
+				if (src->_children[b]) {
+					dst->_children[b] = _make_node(src->_children[b]->_label);
+					stack.emplace_back(dst->_children[b].get(), src->_children[b].get());
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief	destroys subtree without recursion and without allocation
+	 * 			children 0 are rotated to the place of children 1 until the Node has none,
+	 * 			then the Node is deleted and its child 1 is processed
+	 * @param 	slot		owner of the subtree, empty afterwards
+	 */
+	static void _destroy(std::unique_ptr<Node>& slot) noexcept {
+		std::unique_ptr<Node> node = std::move(slot);
+		while (node) {
+			if (node->_children[0]) {
+				std::unique_ptr<Node> left = std::move(node->_children[0]);
+				node->_children[0] = std::move(left->_children[1]);
+				left->_children[1] = std::move(node);
+				node = std::move(left);
+			} else {
+				node = std::move(node->_children[1]);     // Node without children is deleted
+			}
+		}
+	}
+
+	static std::size_t _count(const Node* node) {
+		std::vector<const Node*> stack{ node };
+		std::size_t count = 0;
+		while (!stack.empty()) {
+			node = stack.back();
+			stack.pop_back();
+			++count;
+			for (int b = 0; b < 2; ++b) {
+				if (node->child(b))
+					stack.push_back(node->child(b));
+			}
+		}
+		return count;
+	}
+};
+
+#endif
@@ -0,0 +1,216 @@
+#ifndef PERSISTENT_TRIE_H
+#define PERSISTENT_TRIE_H
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "key_traits.h"
+
+/**
+ *  persistent binary Trie:
+ *  		Nodes are immutable and reference-counted, so copies of PersistentTrie
+ *  		share all Nodes and copying (snapshot) costs one reference count increment
+ *  		insert and remove copy only the Nodes on the key's path and share the rest,
+ *  		values are shared between versions as well and are never copied
+ *  	every copy can be read and modified independently, also from different threads
+ */
+template<typename Value, typename KeyTraits = BitSequenceTraits>
+class PersistentTrie {
+	using Seq = typename KeyTraits::key_type;
+public:
+	using key_type = Seq;
+	using traits_type = KeyTraits;
+
+	/**
+	 * @brief	class representing immutable node of PersistentTrie
+	 */
+	class Node {
+	public:
+		/**
+		 * @brief	child Node getter
+		 * @param 	bit			0 for the left child, 1 for the right one
+		 * @return 	raw pointer to the child Node (nullptr if there is none)
+		 */
+		const Node* child(bool bit) const noexcept {
+			return _children[bit].get();
+		}
+
+		/**
+		 * @brief	value getter
+		 * @return 	raw pointer to the saved value (nullptr if no value is present)
+		 */
+		const Value* value() const noexcept {
+			return _value.get();
+		}
+
+		Node() = default;
+		Node(const Node&) = default;
+
+		/**
+		 * @brief	dtor
+		 * 			children owned only by this Node are moved onto a local stack
+		 * 			and their children are taken over before they are released,
+		 * 			so long keys cannot overflow the stack by nested shared_ptr dtors
+		 */
+		~Node() {
+			std::vector<std::shared_ptr<const Node>> stack;
+			_take_unique(_children, stack);
+			while (!stack.empty()) {
+				std::shared_ptr<const Node> node = std::move(stack.back());
+				stack.pop_back();
+				// every Node is created as non-const Node, only this thread owns it
+				_take_unique(const_cast<Node*>(node.get())->_children, stack);
+			}
+		}
+
+	private:
+		friend class PersistentTrie;
+		std::shared_ptr<const Node> _children[2];
+		std::shared_ptr<const Value> _value;
+
+		static void _take_unique(std::shared_ptr<const Node> (&children)[2],
+				std::vector<std::shared_ptr<const Node>>& stack) {
+			for (std::shared_ptr<const Node>& child : children) {
+				if (child && child.use_count() == 1)
+					stack.push_back(std::move(child));
+			}
+		}
+	};
+
+	/**
+	 * @brief default ctor
+	 */
+	PersistentTrie()
+			: _root(std::make_shared<Node>()) {}
+
+	/**
+	 * @brief	creates snapshot of the current version in O(1)
+	 * @return 	PersistentTrie sharing all Nodes with this one
+	 */
+	PersistentTrie snapshot() const noexcept {
+		return *this;
+	}
+
+	/**
+	 * @brief	root getter
+	 * @return	returns const reference to the root
+	 */
+	const Node& root() const noexcept {
+		return *_root;
+	}
+
+	/**
+	 * @return	number of stored values
+	 */
+	std::size_t size() const noexcept {
+		return _size;
+	}
+
+	/**
+	 * @brief	inserts element, copies O(key length) Nodes
+	 * 			if element is already present insertion will not take a place
+	 * @param 	seq			key
+	 * @param 	val			value to be inserted
+	 * @return	true if insertion succeeds, false otherwise
+	 */
+	bool insert(const Seq& seq, const Value& val) {
+		std::size_t n = KeyTraits::size(seq);
+		std::vector<const Node*> path = _path(seq);
+		if (path.size() == n + 1 && path.back()->value())
+			return false;
+		auto node = _copy(path.size() == n + 1 ? path.back() : nullptr);
+		node->_value = std::make_shared<const Value>(val);
+		std::shared_ptr<const Node> child = std::move(node);
+		_root = _rebuild(path, seq, n, std::move(child));
+		++_size;
+		return true;
+	}
+
+	/**
+	 * @brief	searches for value
+	 * @param 	seq			key
+	 * @return 	const raw pointer to the value, nullptr if value is not present
+	 * 			(valid while this version holds the value)
+	 */
+	const Value* search(const Seq& seq) const noexcept {
+		const Node* node = _root.get();
+		for (std::size_t i = 0, n = KeyTraits::size(seq); node && i < n; ++i)
+			node = node->child(KeyTraits::bit(seq, i));
+		return node ? node->value() : nullptr;
+	}
+
+	/**
+	 * @brief	removes element, copies O(key length) Nodes
+	 * 			Nodes left without value and children are not copied
+	 * @param 	seq 		key
+	 * @return 	true if element was present, false otherwise
+	 */
+	bool remove(const Seq& seq) {
+		std::size_t n = KeyTraits::size(seq);
+		std::vector<const Node*> path = _path(seq);
+		if (path.size() != n + 1 || !path.back()->value())
+			return false;
+		std::shared_ptr<const Node> child;
+		const Node* target = path.back();
+		if (!n || target->child(false) || target->child(true)) {
+			auto node = _copy(target);
+			node->_value.reset();
+			child = std::move(node);
+		}
+		_root = _rebuild(path, seq, n, std::move(child));
+		--_size;
+		return true;
+	}
+
+private:
+	std::shared_ptr<const Node> _root;
+	std::size_t _size = 0;
+
+
+	static std::shared_ptr<Node> _copy(const Node* node) {
+		return node ? std::make_shared<Node>(*node) : std::make_shared<Node>();
+	}
+
+	/**
+	 * @return	Nodes on the key's path starting with the root
+	 * 			(shorter than key length + 1 if the path ends prematurely)
+	 */
+	std::vector<const Node*> _path(const Seq& seq) const {
+		std::vector<const Node*> path{ _root.get() };
+		for (std::size_t i = 0, n = KeyTraits::size(seq); i < n; ++i) {
+			const Node* child = path.back()->child(KeyTraits::bit(seq, i));
+			if (!child)
+				break;
+			path.push_back(child);
+		}
+		return path;
+	}
+
+	/**
+	 * @brief	copies Nodes on the key's path above depth from the bottom up
+	 * 			and links child to them
+	 * 			copies without value and children are dropped, the root never is
+	 * @param 	path		Nodes on the key's path
+	 * @param 	seq			key
+	 * @param 	depth		depth of child
+	 * @param 	child		new Node at depth (nullptr to remove it)
+	 * @return 	new root
+	 */
+	static std::shared_ptr<const Node> _rebuild(const std::vector<const Node*>& path, const Seq& seq,
+			std::size_t depth, std::shared_ptr<const Node> child) {
+		if (!depth)
+			return child;
+		for (std::size_t i = depth; i-- > 0;) {
+			auto node = _copy(i < path.size() ? path[i] : nullptr);
+			node->_children[KeyTraits::bit(seq, i)] = std::move(child);
+			if (i && !node->_value && !node->_children[0] && !node->_children[1])
+				child.reset();
+			else
+				child = std::move(node);
+		}
+		return child;
+	}
+};
+
+#endif
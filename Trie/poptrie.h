@@ -0,0 +1,256 @@
+#ifndef POPTRIE_H
+#define POPTRIE_H
+
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "key_traits.h"
+#include "trie.h"
+
+/**
+ *  read-optimized multibit Trie for longest-prefix match of fixed-width addresses
+ *  (poptrie):
+ *  		every Node consumes 6 bits of the address, presence of child Nodes
+ *  		and of leaves among the 64 possible strides is encoded in 64-bit bitmaps
+ *  		and children/leaves are located by popcount of the bitmap
+ *  		leaves hold the longest matching prefix (pushed down from ancestors),
+ *  		runs of equal leaves are stored only once
+ *  	Poptrie is built from a binary Trie holding the prefixes and can be
+ *  	updated incrementally by rebuilding only the part affected by a prefix
+ */
+template<typename Value, typename UInt>
+class Poptrie {
+	using Bits = detail::IntegerBits<UInt>;
+	using index_type = std::uint32_t;
+
+	static constexpr std::size_t _stride = 6;
+	static constexpr std::size_t _width = Bits::width;
+	static constexpr index_type _no_value = std::numeric_limits<index_type>::max();
+
+	using ValueMap = std::unordered_map<const Value*, index_type>;
+
+public:
+	/**
+	 * @brief	class representing inner node of Poptrie
+	 * 			vector			bit v is set if stride v continues in a child Node
+	 * 			leafvec			bit v is set where a new run of leaves starts
+	 * 			base0			index of the first leaf of this Node
+	 * 			base1			index of the first child of this Node
+	 */
+	struct Node {
+		std::uint64_t vector;
+		std::uint64_t leafvec;
+		index_type base0;
+		index_type base1;
+	};
+
+	/**
+	 * @brief	builds Poptrie from prefixes stored in binary Trie
+	 * @param 	trie		Trie whose keys are prefixes of addresses
+	 */
+	template<typename Traits>
+	explicit Poptrie(const Trie<Value, Traits>& trie) {
+		build(trie);
+	}
+
+	/**
+	 * @brief	rebuilds the whole Poptrie from binary Trie
+	 * @param 	trie		Trie whose keys are prefixes of addresses
+	 */
+	template<typename Traits>
+	void build(const Trie<Value, Traits>& trie) {
+		_nodes.clear();
+		_leaves.clear();
+		_values.clear();
+		ValueMap map;
+		const auto* root = &trie.root();
+		_nodes.push_back(Node{});
+		_build(0, root, 0, _value_index(root->value(), map), map);
+		_built_size = _stored();
+	}
+
+	/**
+	 * @brief	updates Poptrie after prefix has been inserted to or removed from the Trie
+	 * 			rebuilds only the deepest Node whose strides cover the prefix,
+	 * 			the whole Poptrie is rebuilt once abandoned Nodes, leaves and values
+	 * 			outweigh live ones
+	 * @param 	trie		Trie the Poptrie has been built from
+	 * @param 	prefix		changed prefix
+	 */
+	template<typename Traits>
+	void update(const Trie<Value, Traits>& trie, const typename Traits::key_type& prefix) {
+		using TrieNode = typename Trie<Value, Traits>::Node;
+		ValueMap map;
+		std::size_t len = Traits::size(prefix);
+		const TrieNode* bnode = &trie.root();
+		index_type at = 0;
+		std::size_t depth = 0;
+		index_type best = _value_index(bnode->value(), map);
+
+		while (depth + _stride <= len && depth + _stride < _width) {
+			unsigned v = 0;
+			for (std::size_t k = 0; k < _stride; ++k)
+				v = (v << 1) | Traits::bit(prefix, depth + k);
+			const Node& node = _nodes[at];
+			if (!((node.vector >> v) & 1))
+				break;
+			const TrieNode* next = bnode;
+			index_type next_best = best;
+			for (std::size_t k = 0; next && k < _stride; ++k) {
+				next = ((v >> (_stride - 1 - k)) & 1) ? next->right() : next->left();
+				if (next && next->value())
+					next_best = _value_index(next->value(), map);
+			}
+			if (!next || (!next->left() && !next->right()))
+				break;              // the stride turns into a leaf, rebuild this Node
+			at = node.base1 + _rank(node.vector, v) - 1;
+			bnode = next;
+			best = next_best;
+			depth += _stride;
+		}
+		_build(at, bnode, depth, best, map);
+		if (_stored() > 2 * _built_size + 64)
+			build(trie);
+	}
+
+	/**
+	 * @brief	longest-prefix match
+	 * 			reads one Node and at most one leaf per 6 bits of the address
+	 * @param 	address
+	 * @return 	value of the longest prefix of address, nullptr if there is none
+	 */
+	const Value* lookup(const UInt& address) const noexcept {
+		const Node* node = _nodes.data();
+		for (std::size_t pos = 0;; pos += _stride) {
+			unsigned v = _chunk(address, pos);
+			if ((node->vector >> v) & 1) {
+				node = &_nodes[node->base1 + _rank(node->vector, v) - 1];
+				continue;
+			}
+			index_type value = _leaves[node->base0 + _rank(node->leafvec, v) - 1];
+			return value == _no_value ? nullptr : &_values[value];
+		}
+	}
+
+	/**
+	 * @return	number of Nodes (including abandoned ones)
+	 */
+	std::size_t node_count() const noexcept {
+		return _nodes.size();
+	}
+
+	/**
+	 * @return	number of leaves (including abandoned ones)
+	 */
+	std::size_t leaf_count() const noexcept {
+		return _leaves.size();
+	}
+
+	/**
+	 * @return	number of copied values (including abandoned ones)
+	 */
+	std::size_t value_count() const noexcept {
+		return _values.size();
+	}
+
+private:
+	std::vector<Node> _nodes;
+	std::vector<index_type> _leaves;
+	std::vector<Value> _values;
+	std::size_t _built_size = 0;         // _stored() right after the last full build
+
+	/**
+	 * @return	number of Nodes, leaves and values including abandoned ones
+	 */
+	std::size_t _stored() const noexcept {
+		return _nodes.size() + _leaves.size() + _values.size();
+	}
+
+	/**
+	 * @return	number of set bits of bitmap among bits 0..v
+	 */
+	static unsigned _rank(std::uint64_t bitmap, unsigned v) noexcept {
+		std::uint64_t mask = (std::uint64_t(2) << v) - 1;
+		return std::popcount(bitmap & mask);
+	}
+
+	/**
+	 * @return	6 bits of address starting at pos, bits past the width are zero
+	 */
+	static unsigned _chunk(const UInt& address, std::size_t pos) noexcept {
+		unsigned v = 0;
+		for (std::size_t k = 0; k < _stride; ++k)
+			v = (v << 1) | (pos + k < _width && Bits::msb(address, pos + k));
+		return v;
+	}
+
+	index_type _value_index(const Value* value, ValueMap& map) {
+		if (!value)
+			return _no_value;
+		auto it = map.find(value);
+		if (it != map.end())
+			return it->second;
+		_values.push_back(*value);
+		index_type ix = index_type(_values.size() - 1);
+		map.emplace(value, ix);
+		return ix;
+	}
+
+	/**
+	 * @brief	(re)builds Node at from the binary Trie Node at depth
+	 * 			children and leaves of the Node are appended as contiguous blocks
+	 * @param 	at			index of the Node
+	 * @param 	bnode		binary Trie Node
+	 * @param 	depth		depth of bnode, multiple of 6
+	 * @param 	inherited	longest prefix value up to and including bnode
+	 * @param 	map			values already copied during this build
+	 */
+	template<typename TrieNode>
+	void _build(index_type at, const TrieNode* bnode, std::size_t depth, index_type inherited, ValueMap& map) {
+		const TrieNode* children[64];
+		index_type best[64];
+		std::uint64_t vector = 0;
+		for (unsigned v = 0; v < 64; ++v) {
+			const TrieNode* n = bnode;
+			best[v] = inherited;
+			for (std::size_t k = 0; n && k < _stride; ++k) {
+				if (depth + k >= _width) {
+					n = nullptr;
+					break;
+				}
+				n = ((v >> (_stride - 1 - k)) & 1) ? n->right() : n->left();
+				if (n && n->value())
+					best[v] = _value_index(n->value(), map);
+			}
+			children[v] = n;
+			if (n && (n->left() || n->right()) && depth + _stride < _width)
+				vector |= std::uint64_t(1) << v;
+		}
+
+		Node node{ vector, 0, index_type(_leaves.size()), index_type(_nodes.size()) };
+		bool first = true;
+		index_type last = _no_value;
+		for (unsigned v = 0; v < 64; ++v) {
+			if ((vector >> v) & 1)
+				continue;
+			if (first || best[v] != last) {
+				node.leafvec |= std::uint64_t(1) << v;
+				_leaves.push_back(best[v]);
+				last = best[v];
+				first = false;
+			}
+		}
+		_nodes[at] = node;
+		_nodes.resize(_nodes.size() + std::popcount(vector));
+		index_type child = node.base1;
+		for (unsigned v = 0; v < 64; ++v) {
+			if ((vector >> v) & 1)
+				_build(child++, children[v], depth + _stride, best[v], map);
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,1138 @@
+#include "trie.h"
+#include "patricia_trie.h"
+#include "arena_trie.h"
+#include "poptrie.h"
+#include "frozen_trie.h"
+#include "mapped_trie.h"
+#include "concurrent_trie.h"
+#include "persistent_trie.h"
+#include "art.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <pthread.h>
+#include <unistd.h>
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+template class Trie< int >;
+
+using Key = std::vector< bool >;
+using Reference = std::map< Key, int >;
+
+Key randomKey( std::mt19937& gen, std::size_t max_length ) {
+    Key key( gen() % ( max_length + 1 ) );
+    for ( std::size_t i = 0; i < key.size(); ++i ) {
+        key[ i ] = gen() & 1;
+    }
+    return key;
+}
+
+Reference dump( const Trie< int >& trie ) {
+    Reference ref;
+    for ( auto e : trie ) {
+        ref.emplace( e.key, e.value );
+    }
+    return ref;
+}
+
+// runs f on a thread with a stack of the given size, recursion over deep keys would overflow it
+template< typename F >
+void onSmallStack( std::size_t bytes, F f ) {
+    pthread_attr_t attr;
+    pthread_attr_init( &attr );
+    pthread_attr_setstacksize( &attr, bytes );
+    pthread_t thread;
+    auto run = []( void* arg ) -> void* {
+        ( *static_cast< F* >( arg ) )();
+        return nullptr;
+    };
+    REQUIRE( pthread_create( &thread, &attr, run, &f ) == 0 );
+    pthread_join( thread, nullptr );
+    pthread_attr_destroy( &attr );
+}
+
+// random inserts and removes checked against std::map
+template< typename T >
+void checkAgainstMap( T& trie, std::mt19937& gen, std::size_t max_length ) {
+    Reference ref;
+    for ( int i = 0; i < 5000; ++i ) {
+        Key key = randomKey( gen, max_length );
+        if ( gen() % 3 ) {
+            REQUIRE( trie.insert( key, i ) == ref.emplace( key, i ).second );
+        } else {
+            REQUIRE( trie.remove( key ) == ( ref.erase( key ) == 1 ) );
+        }
+        Key probe = randomKey( gen, max_length );
+        auto it = ref.find( probe );
+        const int* found = trie.search( probe );
+        REQUIRE( ( found == nullptr ) == ( it == ref.end() ) );
+        if ( found ) {
+            REQUIRE( *found == it->second );
+        }
+    }
+    for ( auto& [ key, value ] : ref ) {
+        REQUIRE( trie.search( key ) );
+        REQUIRE( *trie.search( key ) == value );
+    }
+}
+
+// insert, search and remove of every key, keys have to be distinct
+template< typename T, typename Keys >
+void roundTrip( T& trie, const Keys& keys ) {
+    int value = 0;
+    for ( auto& key : keys ) {
+        REQUIRE( trie.insert( key, value++ ) );
+        REQUIRE_FALSE( trie.insert( key, -1 ) );
+    }
+    value = 0;
+    for ( auto& key : keys ) {
+        REQUIRE( trie.search( key ) );
+        REQUIRE( *trie.search( key ) == value++ );
+    }
+    for ( std::size_t i = 0; i < keys.size(); i += 2 ) {
+        REQUIRE( trie.remove( keys[ i ] ) );
+        REQUIRE_FALSE( trie.remove( keys[ i ] ) );
+    }
+    for ( std::size_t i = 0; i < keys.size(); ++i ) {
+        const int* found = trie.search( keys[ i ] );
+        if ( i % 2 ) {
+            REQUIRE( found );
+            REQUIRE( *found == int( i ) );
+        } else {
+            REQUIRE_FALSE( found );
+        }
+    }
+}
+
+TEST_CASE( "Trie against map" ) {
+    std::mt19937 gen( 1 );
+    Trie< int > trie;
+    checkAgainstMap( trie, gen, 12 );
+
+    Trie< int > copy( trie );
+    for ( int i = 0; i < 2000; ++i ) {
+        Key key = randomKey( gen, 12 );
+        const int* a = trie.search( key );
+        const int* b = copy.search( key );
+        REQUIRE( ( a == nullptr ) == ( b == nullptr ) );
+        if ( a ) {
+            REQUIRE( *a == *b );
+        }
+    }
+}
+
+TEST_CASE( "integer keys" ) {
+    Trie< int, IntegerKeyTraits< std::uint32_t > > trie;
+    std::vector< std::uint32_t > keys{ 0, 1, 2, 0x80000000u, 0xFFFFFFFFu, 0x7FFFFFFFu, 12345 };
+    roundTrip( trie, keys );
+    REQUIRE_FALSE( trie.search( 3 ) );
+}
+
+TEST_CASE( "Uint128 keys" ) {
+    Trie< int, IntegerKeyTraits< Uint128 > > trie;
+    std::vector< Uint128 > keys{
+        { 0, 0 }, { 0, 1 }, { 1, 0 }, { 0x8000000000000000ull, 0 }, { 0, 0x8000000000000000ull },
+        { 0x20010db800000000ull, 0x1ull }, { 0x20010db800000000ull, 0x2ull }, { ~0ull, ~0ull } };
+    roundTrip( trie, keys );
+    REQUIRE_FALSE( trie.search( Uint128{ 0x20010db800000000ull, 0x3ull } ) );
+    REQUIRE_FALSE( trie.search( Uint128{ 2, 0 } ) );
+}
+
+TEST_CASE( "BitPrefix keys" ) {
+    using Prefix = BitPrefix< std::uint32_t >;
+    Trie< int, PrefixKeyTraits< std::uint32_t > > trie;
+    std::vector< Prefix > keys{
+        Prefix( 0, 0 ), Prefix( 0x0A000000u, 8 ), Prefix( 0x0A010000u, 16 ), Prefix( 0x0A010100u, 24 ),
+        Prefix( 0x0A010101u ), Prefix( 0x80000000u, 1 ) };
+    roundTrip( trie, keys );
+    REQUIRE_FALSE( trie.search( Prefix( 0x0A000000u, 9 ) ) );
+}
+
+TEST_CASE( "BitSpan keys" ) {
+    const std::uint8_t bytes[] = { 0xA5, 0x0F, 0xFF, 0x00 };
+    const std::uint8_t other[] = { 0xA4, 0x0F };
+    Trie< int, BitSpanTraits > trie;
+    std::vector< BitSpan > keys{
+        { bytes, 0 }, { bytes, 1 }, { bytes, 7 }, { bytes, 8 }, { bytes, 13 }, { bytes, 32 }, { other, 8 } };
+    roundTrip( trie, keys );
+
+    const std::uint8_t copy[] = { 0xA5, 0x0F };   // keys are compared by bits, not by address
+    REQUIRE( trie.search( BitSpan{ copy, 8 } ) );
+    REQUIRE( *trie.search( BitSpan{ copy, 8 } ) == 3 );
+    REQUIRE_FALSE( trie.search( BitSpan{ copy, 12 } ) );
+}
+
+TEST_CASE( "PatriciaTrie against map" ) {
+    std::mt19937 gen( 2 );
+    PatriciaTrie< int > trie;
+    checkAgainstMap( trie, gen, 40 );
+    REQUIRE( trie.node_count() <= 2 * trie.size() + 1 );
+
+    PatriciaTrie< int > copy( trie );
+    REQUIRE( copy.size() == trie.size() );
+    REQUIRE( copy.node_count() == trie.node_count() );
+    for ( int i = 0; i < 2000; ++i ) {
+        Key key = randomKey( gen, 40 );
+        const int* a = trie.search( key );
+        const int* b = copy.search( key );
+        REQUIRE( ( a == nullptr ) == ( b == nullptr ) );
+        if ( a ) {
+            REQUIRE( *a == *b );
+        }
+    }
+}
+
+TEST_CASE( "PatriciaTrie nested keys" ) {
+    constexpr std::size_t depth = 8000;       // every key is a prefix of the next one
+    std::vector< std::uint8_t > ones( depth / 8 + 1, 0xFF );
+    std::size_t nodes = 0, copied = 0, copied_nodes = 0;
+    bool found = false;
+    onSmallStack( 128 * 1024, [&] {
+        PatriciaTrie< int, BitSpanTraits > trie;
+        for ( std::size_t i = 1; i <= depth; ++i ) {
+            trie.insert( BitSpan{ ones.data(), i }, int( i ) );
+        }
+        nodes = trie.node_count();
+        PatriciaTrie< int, BitSpanTraits > copy( trie );
+        copied = copy.size();
+        copied_nodes = copy.node_count();
+        found = copy.search( BitSpan{ ones.data(), depth } ) && *copy.search( BitSpan{ ones.data(), depth } ) == int( depth );
+    } );
+    REQUIRE( nodes == depth + 1 );
+    REQUIRE( copied == depth );
+    REQUIRE( copied_nodes == depth + 1 );
+    REQUIRE( found );
+}
+
+TEST_CASE( "ArenaTrie against map" ) {
+    std::mt19937 gen( 3 );
+    ArenaTrie< int > trie;
+    checkAgainstMap( trie, gen, 12 );
+
+    std::size_t nodes = trie.node_count();
+    Key key{ true, true, false, true, true, false, false, true, true, true, true, true, true, true, true };
+    bool fresh = trie.insert( key, 1 );
+    REQUIRE( trie.remove( key ) == fresh );
+    REQUIRE( trie.node_count() == nodes );         // Nodes of the removed key are freed
+    REQUIRE( trie.insert( key, 2 ) );
+    REQUIRE( *trie.search( key ) == 2 );
+
+    trie.clear();
+    REQUIRE( trie.size() == 0 );
+    REQUIRE( trie.node_count() == 1 );
+    REQUIRE_FALSE( trie.search( key ) );
+}
+
+TEST_CASE( "Poptrie lookup after updates" ) {
+    using Prefix = BitPrefix< std::uint32_t >;
+    std::mt19937 gen( 12 );
+    Trie< int, PrefixKeyTraits< std::uint32_t > > trie;
+    std::vector< Prefix > prefixes;
+    auto randomPrefix = [&] {
+        std::size_t length = gen() % 33;
+        std::uint32_t bits = gen();
+        if ( length < 32 ) {
+            bits &= ~( 0xFFFFFFFFu >> length );
+        }
+        return Prefix( bits, length );
+    };
+    for ( int i = 0; i < 300; ++i ) {
+        prefixes.push_back( randomPrefix() );
+        trie.insert( prefixes.back(), i );
+    }
+    Poptrie< int, std::uint32_t > poptrie( trie );
+    auto check = [&] {
+        for ( int i = 0; i < 2000; ++i ) {
+            std::uint32_t address = i % 2 ? prefixes[ gen() % prefixes.size() ].bits | ( gen() & 0xFF ) : gen();
+            const int* a = poptrie.lookup( address );
+            const int* b = trie.longest_prefix_match( Prefix( address ) ).value;
+            REQUIRE( ( a == nullptr ) == ( b == nullptr ) );
+            if ( a ) {
+                REQUIRE( *a == *b );
+            }
+        }
+    };
+    check();
+    for ( int i = 0; i < 200; ++i ) {
+        if ( gen() % 2 ) {
+            Prefix prefix = prefixes[ gen() % prefixes.size() ];
+            trie.remove( prefix );
+            poptrie.update( trie, prefix );
+        } else {
+            prefixes.push_back( randomPrefix() );
+            trie.insert( prefixes.back(), 1000 + i );
+            poptrie.update( trie, prefixes.back() );
+        }
+        if ( i % 20 == 0 ) {
+            check();
+        }
+    }
+    check();
+}
+
+TEST_CASE( "Poptrie churn stays bounded" ) {
+    using Prefix = BitPrefix< std::uint32_t >;
+    Trie< int, PrefixKeyTraits< std::uint32_t > > trie;
+    for ( std::uint32_t i = 0; i < 64; ++i ) {
+        trie.insert( Prefix( i << 26, 6 ), int( i ) );     // same shape after every update
+    }
+    Poptrie< int, std::uint32_t > poptrie( trie );
+    std::size_t built = poptrie.node_count() + poptrie.leaf_count() + poptrie.value_count();
+    std::mt19937 gen( 13 );
+    for ( int i = 0; i < 20000; ++i ) {
+        Prefix prefix( std::uint32_t( gen() % 64 ) << 26, 6 );
+        if ( trie.remove( prefix ) ) {
+            poptrie.update( trie, prefix );
+        }
+        trie.insert( prefix, i );
+        poptrie.update( trie, prefix );
+        REQUIRE( poptrie.node_count() + poptrie.leaf_count() + poptrie.value_count() <= 2 * built + 64 );
+    }
+    for ( std::uint32_t i = 0; i < 64; ++i ) {
+        REQUIRE( *poptrie.lookup( i << 26 ) == *trie.search( Prefix( i << 26, 6 ) ) );
+    }
+}
+
+TEST_CASE( "longest_prefix_match and all_prefixes" ) {
+    Trie< int > trie;
+    REQUIRE_FALSE( trie.longest_prefix_match( { true } ).value );
+    REQUIRE( trie.all_prefixes( { true } ).empty() );
+
+    trie.insert( {}, 0 );
+    trie.insert( { true }, 1 );
+    trie.insert( { true, false, true }, 3 );
+    trie.insert( { true, false, true, true, false }, 5 );
+    trie.insert( { false, false }, 7 );
+
+    SECTION( "key is stored" ) {
+        Key key{ true, false, true };
+        auto match = trie.longest_prefix_match( key );
+        REQUIRE( *match.value == 3 );
+        REQUIRE( match.length == 3 );
+        auto all = trie.all_prefixes( key );
+        REQUIRE( all.size() == 3 );
+        REQUIRE( *all[ 0 ].value == 0 );
+        REQUIRE( all[ 0 ].length == 0 );
+        REQUIRE( *all[ 1 ].value == 1 );
+        REQUIRE( all[ 1 ].length == 1 );
+        REQUIRE( *all[ 2 ].value == 3 );
+        REQUIRE( all[ 2 ].length == 3 );
+    }
+    SECTION( "key is not stored" ) {
+        Key key{ true, false, true, true, true, false };     // leaves the Trie after 4 bits
+        auto match = trie.longest_prefix_match( key );
+        REQUIRE( *match.value == 3 );
+        REQUIRE( match.length == 3 );
+        auto all = trie.all_prefixes( key );
+        REQUIRE( all.size() == 3 );
+        REQUIRE( all.back().length == 3 );
+
+        Key longer{ true, false, true, true, false, true, true };
+        REQUIRE( trie.longest_prefix_match( longer ).length == 5 );
+        REQUIRE( trie.all_prefixes( longer ).size() == 4 );
+    }
+    SECTION( "only the root matches" ) {
+        Key key{ false, true };
+        auto match = trie.longest_prefix_match( key );
+        REQUIRE( *match.value == 0 );
+        REQUIRE( match.length == 0 );
+        REQUIRE( trie.all_prefixes( key ).size() == 1 );
+
+        trie.remove( {} );
+        REQUIRE_FALSE( trie.longest_prefix_match( key ).value );
+        REQUIRE( trie.all_prefixes( key ).empty() );
+    }
+}
+
+TEST_CASE( "longest_prefix_match against prefix searches" ) {
+    std::mt19937 gen( 16 );
+    Trie< int > trie;
+    for ( int i = 0; i < 2000; ++i ) {
+        trie.insert( randomKey( gen, 16 ), i );
+    }
+    for ( int i = 0; i < 2000; ++i ) {
+        Key key = randomKey( gen, 20 );
+        std::vector< std::pair< int, std::size_t > > expected;
+        for ( std::size_t length = 0; length <= key.size(); ++length ) {
+            if ( const int* value = trie.search( Key( key.begin(), key.begin() + length ) ) ) {
+                expected.emplace_back( *value, length );
+            }
+        }
+        auto all = trie.all_prefixes( key );
+        REQUIRE( all.size() == expected.size() );
+        for ( std::size_t j = 0; j < all.size(); ++j ) {
+            REQUIRE( *all[ j ].value == expected[ j ].first );
+            REQUIRE( all[ j ].length == expected[ j ].second );
+        }
+        auto match = trie.longest_prefix_match( key );
+        if ( expected.empty() ) {
+            REQUIRE_FALSE( match.value );
+        } else {
+            REQUIRE( *match.value == expected.back().first );
+            REQUIRE( match.length == expected.back().second );
+        }
+    }
+}
+
+TEST_CASE( "iteration order" ) {
+    Trie< int > trie;
+    REQUIRE( trie.begin() == trie.end() );
+
+    trie.insert( { true, false }, 4 );
+    trie.insert( { false, true }, 2 );
+    trie.insert( {}, 0 );
+    trie.insert( { true }, 3 );
+    trie.insert( { false }, 1 );
+    trie.insert( { false, true, true, true }, 5 );
+
+    std::vector< Key > keys;
+    std::vector< int > values;
+    for ( auto it = trie.begin(); it != trie.end(); ++it ) {
+        keys.push_back( it.key() );
+        values.push_back( it.value() );
+    }
+    std::vector< Key > expected_keys{ {}, { false }, { false, true }, { false, true, true, true }, { true }, { true, false } };
+    std::vector< int > expected_values{ 0, 1, 2, 5, 3, 4 };
+    REQUIRE( keys == expected_keys );
+    REQUIRE( values == expected_values );
+
+    std::vector< int > visited;
+    trie.for_each( [&]( const int& v ) { visited.push_back( v ); } );
+    REQUIRE( visited == values );
+
+    std::vector< int > ranged;
+    for ( auto e : trie.prefix_range( { false, true } ) ) {
+        ranged.push_back( e.value );
+    }
+    REQUIRE( ranged.size() == 2 );
+    REQUIRE( ranged[ 0 ] == 2 );
+    REQUIRE( ranged[ 1 ] == 5 );
+    auto missing = trie.prefix_range( { true, true } );
+    REQUIRE( missing.begin() == missing.end() );
+    auto first = trie.prefix_range( { false, true, true } ).begin();
+    REQUIRE( first.value() == 5 );
+    REQUIRE( first.key().size() == 4 );
+}
+
+TEST_CASE( "iterators and prefix_range against map" ) {
+    std::mt19937 gen( 7 );
+    Trie< int > trie;
+    Reference ref;
+    for ( int i = 0; i < 1000; ++i ) {
+        Key key = randomKey( gen, 10 );
+        trie.insert( key, i );
+        ref.emplace( key, i );
+    }
+    REQUIRE( dump( trie ) == ref );
+
+    std::size_t count = 0;
+    auto expected = ref.begin();
+    bool ordered = true;
+    trie.for_each( [&]( const int& v ) {
+        ordered = ordered && v == expected->second;
+        ++expected;
+        ++count;
+    } );
+    REQUIRE( ordered );
+    REQUIRE( count == ref.size() );
+
+    Key prefix{ true, false };
+    Reference under;
+    for ( auto& [ key, value ] : ref ) {
+        if ( key.size() >= 2 && key[ 0 ] && !key[ 1 ] ) {
+            under.emplace( key, value );
+        }
+    }
+    Reference ranged;
+    for ( auto e : trie.prefix_range( prefix ) ) {
+        ranged.emplace( e.key, e.value );
+    }
+    REQUIRE( ranged == under );
+}
+
+TEST_CASE( "remove prunes the key's path" ) {
+    Trie< int > trie;
+    trie.insert( { true, true, true, true }, 1 );
+    trie.insert( { true, true }, 2 );
+    REQUIRE( trie.stats().node_count == 5 );
+
+    REQUIRE( trie.remove( { true, true, true, true } ) );
+    REQUIRE( trie.stats().node_count == 3 );       // the chain below the stored prefix is gone
+    REQUIRE_FALSE( trie.remove( { true } ) );      // Node without value
+    REQUIRE_FALSE( trie.remove( { true, true, true } ) );
+    REQUIRE( trie.remove( { true, true } ) );
+    REQUIRE( trie.stats().node_count == 1 );
+    REQUIRE_FALSE( trie.root().right() );
+}
+
+TEST_CASE( "remove_all" ) {
+    std::mt19937 gen( 17 );
+    Trie< int > trie;
+    std::vector< Key > left, right;
+    for ( int i = 0; i < 500; ++i ) {
+        Key key = randomKey( gen, 12 );
+        key.insert( key.begin(), false );
+        if ( trie.insert( key, i ) ) {
+            left.push_back( key );
+        }
+    }
+    auto before = trie.stats();
+    REQUIRE( before.value_count == left.size() );
+
+    SECTION( "empty subtree" ) {
+        for ( int i = 0; i < 100; ++i ) {
+            Key key = randomKey( gen, 12 );
+            key.insert( key.begin(), true );
+            right.push_back( key );
+        }
+        REQUIRE( trie.remove_all( right ) == 0 );
+        auto after = trie.stats();
+        REQUIRE( after.value_count == before.value_count );
+        REQUIRE( after.node_count == before.node_count );
+    }
+    SECTION( "non-empty subtree" ) {
+        for ( int i = 0; i < 300; ++i ) {
+            Key key = randomKey( gen, 12 );
+            key.insert( key.begin(), true );
+            if ( trie.insert( key, i ) ) {
+                right.push_back( key );
+            }
+        }
+        right.push_back( right.front() );                 // removed only once
+        REQUIRE( trie.remove_all( right ) == right.size() - 1 );
+        auto after = trie.stats();
+        REQUIRE( after.value_count == left.size() );
+        REQUIRE( after.node_count == before.node_count ); // whole subtree of 1 is pruned
+        REQUIRE_FALSE( trie.root().right() );
+        for ( auto& key : left ) {
+            REQUIRE( trie.search( key ) );
+        }
+
+        REQUIRE( trie.remove_all( left ) == left.size() );
+        REQUIRE( trie.stats().value_count == 0 );
+        REQUIRE( trie.stats().node_count == 1 );
+        REQUIRE( trie.begin() == trie.end() );
+    }
+}
+
+TEST_CASE( "deep keys" ) {
+    constexpr std::size_t depth = 1 << 20;    // recursion over this many levels overflows an 8 MiB stack
+    Key deep( depth ), other( depth );
+    for ( std::size_t i = 0; i < depth; ++i ) {
+        deep[ i ] = i % 3 == 0;
+        other[ i ] = deep[ i ];
+    }
+    other.back() = !other.back();
+    auto sum = []( int a, int b ) { return a + b; };
+
+    Trie< int > trie;
+    trie.insert( deep, 1 );
+    {
+        Trie< int > copy( trie );
+        REQUIRE( *copy.search( deep ) == 1 );
+
+        Trie< int > second;
+        second.insert( other, 2 );
+        second.insert( deep, 10 );
+        copy.uniteWith( second, sum );
+        REQUIRE( *copy.search( deep ) == 11 );
+        REQUIRE( *copy.search( other ) == 2 );
+
+        Trie< int > only;
+        only.insert( other, 5 );
+        copy.intersectWith( only, sum );
+        REQUIRE( *copy.search( other ) == 7 );
+        REQUIRE_FALSE( copy.search( deep ) );
+        REQUIRE( copy.stats().node_count == depth + 1 );
+    }                                           // destruction of several deep Tries
+    Trie< int > moved;
+    moved.uniteWith( std::move( trie ), sum );
+    REQUIRE( *moved.search( deep ) == 1 );
+    REQUIRE( moved.remove( deep ) );
+    REQUIRE( moved.stats().node_count == 1 );
+}
+
+TEST_CASE( "build_from_sorted" ) {
+    std::mt19937 gen( 6 );
+    Reference ref;
+    for ( int i = 0; i < 2000; ++i ) {
+        ref.emplace( randomKey( gen, 14 ), i );
+    }
+
+    SECTION( "Trie" ) {
+        Trie< int > bulk, loop;
+        bulk.insert( { true }, -1 );
+        REQUIRE( bulk.build_from_sorted( ref ) == ref.size() );
+        for ( auto& [ key, value ] : ref ) {
+            loop.insert( key, value );
+        }
+        REQUIRE( dump( bulk ) == ref );
+        REQUIRE( bulk.stats().node_count == loop.stats().node_count );
+    }
+    SECTION( "Trie with unsorted and repeated keys" ) {
+        std::vector< std::pair< Key, int > > entries( ref.rbegin(), ref.rend() );
+        entries.emplace_back( entries.front().first, -1 );
+        Trie< int > bulk;
+        REQUIRE( bulk.build_from_sorted( entries ) == ref.size() );
+        REQUIRE( dump( bulk ) == ref );
+    }
+    SECTION( "ArenaTrie" ) {
+        ArenaTrie< int > bulk, loop;
+        bulk.insert( { true }, -1 );
+        REQUIRE( bulk.build_from_sorted( ref ) == ref.size() );
+        for ( auto& [ key, value ] : ref ) {
+            loop.insert( key, value );
+        }
+        REQUIRE( bulk.size() == ref.size() );
+        REQUIRE( bulk.node_count() == loop.node_count() );
+        for ( auto& [ key, value ] : ref ) {
+            REQUIRE( *bulk.search( key ) == value );
+        }
+    }
+}
+
+TEST_CASE( "FrozenTrie matches Trie" ) {
+    std::mt19937 gen( 11 );
+    Trie< int > trie;
+    REQUIRE( trie.freeze().search( {} ) == nullptr );
+    trie.insert( {}, -1 );
+    std::size_t stored = 1;
+    for ( int i = 0; i < 3000; ++i ) {
+        stored += trie.insert( randomKey( gen, 16 ), i );
+    }
+    auto frozen = trie.freeze();
+    REQUIRE( frozen.size() == stored );
+    REQUIRE( frozen.node_count() == trie.stats().node_count );    // many 512-bit rank blocks
+    for ( auto e : trie ) {
+        REQUIRE( *frozen.search( e.key ) == e.value );
+    }
+    for ( int i = 0; i < 5000; ++i ) {
+        Key key = randomKey( gen, 18 );
+        const int* a = trie.search( key );
+        const int* b = frozen.search( key );
+        REQUIRE( ( a == nullptr ) == ( b == nullptr ) );
+        if ( a ) {
+            REQUIRE( *a == *b );
+        }
+        auto m1 = trie.longest_prefix_match( key );
+        auto m2 = frozen.longest_prefix_match( key );
+        REQUIRE( m1.length == m2.length );
+        REQUIRE( *m1.value == *m2.value );
+    }
+}
+
+TEST_CASE( "MappedTrie save and reopen" ) {
+    std::mt19937 gen( 13 );
+    Trie< double > trie;
+    trie.insert( {}, 0.5 );
+    for ( int i = 0; i < 3000; ++i ) {
+        trie.insert( randomKey( gen, 24 ), i );
+    }
+    std::string path = "mapped_trie_test." + std::to_string( ::getpid() );
+    MappedTrie< double >::save( trie, path );
+    {
+        MappedTrie< double > mapped( path );
+        REQUIRE( mapped.node_count() == trie.stats().node_count );
+        REQUIRE( mapped.size() == trie.stats().value_count );
+        for ( int i = 0; i < 5000; ++i ) {
+            Key key = randomKey( gen, 26 );
+            const double* a = trie.search( key );
+            const double* b = mapped.search( key );
+            REQUIRE( ( a == nullptr ) == ( b == nullptr ) );
+            if ( a ) {
+                REQUIRE( *a == *b );
+            }
+            REQUIRE( trie.longest_prefix_match( key ).length == mapped.longest_prefix_match( key ).length );
+        }
+        REQUIRE_THROWS_AS( MappedTrie< float >{ path }, const std::runtime_error& );
+    }
+
+    // overwrites 4 bytes of the file, Nodes start at offset 64 and take 12 bytes each
+    auto patch = [ & ]( std::size_t offset, std::uint32_t index ) {
+        std::fstream file( path, std::ios::in | std::ios::out | std::ios::binary );
+        file.seekp( offset );
+        file.write( reinterpret_cast< const char* >( &index ), sizeof( index ) );
+    };
+    SECTION( "child index out of range" ) {
+        patch( 64 + 12 * 5, std::uint32_t( trie.stats().node_count ) );
+        REQUIRE_THROWS_AS( MappedTrie< double >{ path }, const std::runtime_error& );
+    }
+    SECTION( "value index out of range" ) {
+        patch( 64 + 8, std::uint32_t( trie.stats().value_count ) );
+        REQUIRE_THROWS_AS( MappedTrie< double >{ path }, const std::runtime_error& );
+    }
+    SECTION( "truncated file" ) {
+        std::ifstream in( path, std::ios::binary | std::ios::ate );
+        REQUIRE( ::truncate( path.c_str(), std::size_t( in.tellg() ) - 1 ) == 0 );
+        REQUIRE_THROWS_AS( MappedTrie< double >{ path }, const std::runtime_error& );
+        REQUIRE( ::truncate( path.c_str(), 32 ) == 0 );
+        REQUIRE_THROWS_AS( MappedTrie< double >{ path }, const std::runtime_error& );
+    }
+    std::remove( path.c_str() );
+    REQUIRE_THROWS_AS( MappedTrie< double >{ path }, const std::system_error& );
+}
+
+TEST_CASE( "ConcurrentTrie against map" ) {
+    std::mt19937 gen( 14 );
+    ConcurrentTrie< int > trie;
+    Reference ref;
+    for ( int i = 0; i < 5000; ++i ) {
+        Key key = randomKey( gen, 10 );
+        if ( gen() % 2 ) {
+            REQUIRE( trie.insert( key, i ) == ref.emplace( key, i ).second );
+        } else {
+            REQUIRE( trie.remove( key ) == ( ref.erase( key ) == 1 ) );
+        }
+    }
+    REQUIRE( trie.size() == ref.size() );
+    for ( auto& [ key, value ] : ref ) {
+        REQUIRE( *trie.search( key ) == value );
+    }
+    REQUIRE( trie.pending() == 0 );
+
+    auto [ key, value ] = *ref.begin();
+    REQUIRE( trie.visit( key, [&]( const int& v ) {
+        REQUIRE( v == value );
+        trie.remove( key );                 // nested pin keeps the old version alive
+        REQUIRE( !trie.search( key ) );
+    } ) );
+    trie.reclaim();
+    REQUIRE( trie.pending() == 0 );
+}
+
+TEST_CASE( "ConcurrentTrie readers during updates" ) {
+    ConcurrentTrie< unsigned, IntegerKeyTraits< unsigned > > trie;
+    for ( unsigned i = 0; i < 1000; ++i ) {
+        trie.insert( i * 2, i );
+    }
+    std::atomic< bool > stop{ false };
+    std::atomic< bool > wrong{ false };
+    std::vector< std::thread > readers;
+    for ( unsigned r = 0; r < 4; ++r ) {
+        readers.emplace_back( [&, r] {
+            for ( unsigned i = r; !stop; ++i ) {
+                auto v = trie.search( ( i % 1000 ) * 2 );
+                if ( !v || *v != i % 1000 ) {
+                    wrong = true;
+                }
+            }
+        } );
+    }
+    std::mt19937 gen( 15 );
+    for ( int i = 0; i < 20000; ++i ) {
+        unsigned key = ( gen() % 1000 ) * 2 + 1;
+        if ( gen() % 2 ) {
+            trie.insert( key, key );
+        } else {
+            trie.remove( key );
+        }
+    }
+    stop = true;
+    for ( auto& reader : readers ) {
+        reader.join();
+    }
+    REQUIRE( !wrong );
+    trie.reclaim();
+    REQUIRE( trie.pending() == 0 );
+}
+
+TEST_CASE( "ConcurrentTrie nested pins on a spare slot" ) {
+    ConcurrentTrie< int > trie;
+    Key key{ true, false }, other{ false };
+    trie.insert( key, 1 );
+    trie.insert( other, 2 );
+
+    // keep the first 128 slots owned, so the next thread reads through a spare slot
+    constexpr int holders = 130;
+    std::atomic< int > ready{ 0 };
+    std::atomic< bool > done{ false };
+    std::vector< std::thread > threads;
+    for ( int i = 0; i < holders; ++i ) {
+        threads.emplace_back( [ & ] {
+            trie.search( key );
+            ++ready;
+            while ( !done ) {
+                std::this_thread::yield();
+            }
+        } );
+    }
+    while ( ready != holders ) {
+        std::this_thread::yield();
+    }
+
+    std::size_t levels = 0, pending = 0;
+    std::thread reader( [ & ] {
+        // deeper than the number of spare slots, each level taking a slot would spin forever
+        std::function< void( int ) > nest = [ & ]( int level ) {
+            if ( level == 0 ) {
+                trie.remove( other );               // the outer Guard keeps the old version alive
+                pending = trie.pending();
+                return;
+            }
+            trie.visit( key, [ & ]( const int& ) {
+                ++levels;
+                nest( level - 1 );
+            } );
+        };
+        nest( 20 );
+    } );
+    reader.join();
+    done = true;
+    for ( auto& thread : threads ) {
+        thread.join();
+    }
+    REQUIRE( levels == 20 );
+    REQUIRE( pending > 0 );
+    trie.reclaim();
+    REQUIRE( trie.pending() == 0 );              // spare slot was given back
+}
+
+TEST_CASE( "parallel merges match sequential ones" ) {
+    std::mt19937 gen( 8 );
+    auto zip = []( int a, int b ) { return a * 3 + b; };
+    for ( std::size_t count : { 500, 60000 } ) {
+        Trie< int > a, b;
+        for ( std::size_t i = 0; i < count; ++i ) {
+            Key key = randomKey( gen, 20 );
+            ( gen() % 2 ? a : b ).insert( key, int( i ) );
+            if ( i % 3 == 0 ) {
+                a.insert( key, int( i ) );
+                b.insert( key, int( i ) + 1 );
+            }
+        }
+        for ( unsigned threads : { 1u, 2u, 4u } ) {
+            Trie< int > sequential( a ), parallel( a );
+            sequential.uniteWith( b, zip );
+            parallel.parallelUniteWith( b, zip, threads );
+            REQUIRE( dump( parallel ) == dump( sequential ) );
+
+            Trie< int > sequential2( a ), parallel2( a );
+            sequential2.intersectWith( b, zip );
+            parallel2.parallelIntersectWith( b, zip, threads );
+            REQUIRE( dump( parallel2 ) == dump( sequential2 ) );
+            REQUIRE( parallel2.stats().node_count == sequential2.stats().node_count );
+        }
+    }
+}
+
+TEST_CASE( "parallel merge rethrows" ) {
+    std::mt19937 gen( 9 );
+    Trie< int > a, b;
+    for ( int i = 0; i < 40000; ++i ) {
+        Key key = randomKey( gen, 20 );
+        a.insert( key, i );
+        b.insert( key, i );
+    }
+    auto fail = []( int, int ) -> int { throw std::runtime_error( "zip" ); };
+    REQUIRE_THROWS_AS( a.parallelUniteWith( b, fail, 4 ), const std::runtime_error& );
+    REQUIRE_THROWS_AS( a.parallelIntersectWith( b, fail, 4 ), const std::runtime_error& );
+}
+
+TEST_CASE( "search_batch matches search" ) {
+    std::mt19937 gen( 16 );
+    Trie< int > trie;
+    for ( int i = 0; i < 2000; ++i ) {
+        trie.insert( randomKey( gen, 14 ), i );
+    }
+    trie.remove( {} );
+    // more than one batch of 32, keys of different lengths, missing keys,
+    // prefixes of stored keys without value and the empty key repeated
+    std::vector< Key > keys;
+    for ( int i = 0; i < 1001; ++i ) {
+        keys.push_back( i % 97 == 0 ? Key{} : randomKey( gen, 18 ) );
+    }
+    const int sentinel = 0;
+    std::vector< const int* > found( keys.size(), &sentinel );
+
+    trie.search_batch( keys, found.begin() );
+    for ( std::size_t i = 0; i < keys.size(); ++i ) {
+        REQUIRE( found[ i ] == trie.search( keys[ i ] ) );
+    }
+    REQUIRE( std::count( found.begin(), found.end(), nullptr ) > 0 );
+    REQUIRE( std::count( found.begin(), found.end(), nullptr ) < std::ptrdiff_t( keys.size() ) );
+    REQUIRE( found[ 0 ] == nullptr );
+
+    trie.insert( {}, -1 );
+    trie.search_batch( keys, found.begin() );
+    for ( std::size_t i = 0; i < keys.size(); ++i ) {
+        REQUIRE( found[ i ] == trie.search( keys[ i ] ) );
+    }
+    REQUIRE( *found[ 0 ] == -1 );
+
+    std::vector< Key > none;
+    trie.search_batch( none, found.begin() );
+}
+
+TEST_CASE( "PersistentTrie against map" ) {
+    std::mt19937 gen( 4 );
+    PersistentTrie< int > trie;
+    Reference ref;
+    std::vector< std::pair< PersistentTrie< int >, Reference > > versions;
+    for ( int i = 0; i < 5000; ++i ) {
+        Key key = randomKey( gen, 10 );
+        if ( gen() % 2 ) {
+            REQUIRE( trie.insert( key, i ) == ref.emplace( key, i ).second );
+        } else {
+            REQUIRE( trie.remove( key ) == ( ref.erase( key ) == 1 ) );
+        }
+        REQUIRE( trie.size() == ref.size() );
+        if ( i % 500 == 0 ) {
+            versions.emplace_back( trie.snapshot(), ref );
+        }
+    }
+    for ( auto& [ version, expected ] : versions ) {
+        REQUIRE( version.size() == expected.size() );
+        for ( auto& [ key, value ] : expected ) {
+            REQUIRE( *version.search( key ) == value );
+        }
+    }
+}
+
+TEST_CASE( "PersistentTrie deep keys" ) {
+    constexpr std::size_t depth = 1 << 20;    // nested shared_ptr dtors over this many levels overflow the stack
+    Key deep( depth ), other( depth );
+    for ( std::size_t i = 0; i < depth; ++i ) {
+        deep[ i ] = i % 3 == 0;
+        other[ i ] = deep[ i ];
+    }
+    other.back() = !other.back();
+
+    PersistentTrie< int > trie;
+    REQUIRE( trie.insert( deep, 1 ) );
+    {
+        PersistentTrie< int > snapshot = trie.snapshot();
+        REQUIRE( trie.insert( other, 2 ) );      // shares all but the last Node with the snapshot
+        REQUIRE( trie.remove( deep ) );
+        REQUIRE( *snapshot.search( deep ) == 1 );
+        REQUIRE_FALSE( snapshot.search( other ) );
+    }                                           // releases the snapshot's own path
+    REQUIRE( *trie.search( other ) == 2 );
+    REQUIRE_FALSE( trie.search( deep ) );
+    {
+        PersistentTrie< int > last = trie.snapshot();
+        trie = PersistentTrie< int >();
+        REQUIRE( last.size() == 1 );
+    }                                           // releases the whole path
+    REQUIRE( trie.size() == 0 );
+}
+
+TEST_CASE( "Trie move ctor and move assignment" ) {
+    static_assert( std::is_nothrow_move_constructible< Trie< int > >::value );
+    static_assert( std::is_nothrow_move_assignable< Trie< int > >::value );
+    std::mt19937 gen( 17 );
+    Trie< int > trie;
+    trie.insert( {}, -1 );
+    for ( int i = 0; i < 500; ++i ) {
+        trie.insert( randomKey( gen, 10 ), i );
+    }
+    Reference ref = dump( trie );
+    std::size_t nodes = trie.stats().node_count;
+
+    Trie< int > moved( std::move( trie ) );
+    REQUIRE( dump( moved ) == ref );
+    REQUIRE( moved.stats().node_count == nodes );
+    REQUIRE( trie.begin() == trie.end() );
+    REQUIRE( trie.stats().node_count == 1 );
+    trie.insert( { true }, 1 );                 // moved-from Trie stays usable
+
+    Trie< int > assigned;
+    assigned.insert( { false, false }, 7 );
+    assigned = std::move( moved );
+    REQUIRE( dump( assigned ) == ref );
+    REQUIRE( moved.begin() == moved.end() );
+    REQUIRE( moved.stats().node_count == 1 );
+
+    Trie< int >& self = assigned;
+    assigned = std::move( self );
+    REQUIRE( dump( assigned ) == ref );
+}
+
+using Strings = std::map< std::string, int >;
+
+Strings dump( const Art< int >& art ) {
+    std::vector< std::pair< std::string, int > > visited;
+    art.for_each( [ & ]( const std::string& key, const int& value ) {
+        visited.emplace_back( key, value );
+    } );
+    REQUIRE( std::is_sorted( visited.begin(), visited.end() ) );
+    return Strings( visited.begin(), visited.end() );
+}
+
+TEST_CASE( "Art against map" ) {
+    std::mt19937 gen( 5 );
+    for ( int alphabet : { 2, 40, 256 } ) {
+        Art< int > art;
+        Strings ref;
+        for ( int i = 0; i < 5000; ++i ) {
+            std::string key( gen() % 6, '\0' );
+            for ( auto& c : key ) {
+                c = char( gen() % alphabet );
+            }
+            if ( gen() % 3 ) {
+                REQUIRE( art.insert( key, i ) == ref.emplace( key, i ).second );
+            } else {
+                REQUIRE( art.remove( key ) == ( ref.erase( key ) == 1 ) );
+            }
+            const int* found = art.search( key );
+            REQUIRE( ( found == nullptr ) == ( ref.count( key ) == 0 ) );
+        }
+        REQUIRE( art.size() == ref.size() );
+        REQUIRE( dump( art ) == ref );
+        for ( auto& [ key, value ] : ref ) {
+            REQUIRE( *art.search( key ) == value );
+        }
+    }
+}
+
+TEST_CASE( "Art grows and shrinks Nodes" ) {
+    Art< int > art;
+    Strings ref;
+    std::string prefix( 40, 'p' );              // compressed into the Node
+    for ( int byte = 0; byte < 256; ++byte ) {  // Node4 -> Node16 -> Node48 -> Node256
+        std::string key = prefix + char( byte ) + "suffix";
+        REQUIRE( art.insert( key, byte ) );
+        ref.emplace( key, byte );
+        REQUIRE( dump( art ) == ref );
+    }
+    REQUIRE( art.insert( prefix, -1 ) );          // terminal of the branching Node
+    REQUIRE( art.insert( prefix.substr( 0, 10 ), -2 ) );  // splits the prefix
+    ref.emplace( prefix, -1 );
+    ref.emplace( prefix.substr( 0, 10 ), -2 );
+    REQUIRE( dump( art ) == ref );
+
+    for ( int byte = 255; byte >= 0; --byte ) {  // and back down to a Leaf
+        std::string key = prefix + char( byte ) + "suffix";
+        REQUIRE( art.remove( key ) );
+        REQUIRE_FALSE( art.remove( key ) );
+        ref.erase( key );
+        REQUIRE( dump( art ) == ref );
+        REQUIRE( *art.search( prefix ) == -1 );
+    }
+    REQUIRE( art.remove( prefix ) );
+    REQUIRE( art.size() == 1 );
+    REQUIRE( *art.search( prefix.substr( 0, 10 ) ) == -2 );
+    REQUIRE( art.remove( prefix.substr( 0, 10 ) ) );
+    REQUIRE( art.size() == 0 );
+    REQUIRE_FALSE( art.search( "" ) );
+}
+
+TEST_CASE( "Art copy and move with uniteWith" ) {
+    std::mt19937 gen( 18 );
+    Art< int > a, b;
+    Strings ref;
+    for ( int i = 0; i < 2000; ++i ) {
+        std::string key( gen() % 5, '\0' );
+        for ( auto& c : key ) {
+            c = char( 'a' + gen() % 4 );
+        }
+        ( gen() % 2 ? a : b ).insert( key, i );
+    }
+    Strings left = dump( a ), right = dump( b ), united = left;
+    for ( auto& [ key, value ] : right ) {
+        auto [ it, inserted ] = united.emplace( key, value );
+        if ( !inserted ) {
+            it->second = it->second * 3 + value;
+        }
+    }
+
+    Art< int > copy( a );
+    copy.uniteWith( b, []( int x, int y ) { return x * 3 + y; } );
+    REQUIRE( dump( copy ) == united );
+    REQUIRE( dump( a ) == left );
+
+    Art< int > moved( std::move( copy ) );
+    REQUIRE( dump( moved ) == united );
+    REQUIRE( copy.size() == 0 );
+    a = std::move( moved );
+    REQUIRE( dump( a ) == united );
+    a = b;
+    REQUIRE( dump( a ) == right );
+}
+
+TEST_CASE( "uniteWith rvalue empties other" ) {
+    std::mt19937 gen( 10 );
+    Trie< int > a, b;
+    for ( int i = 0; i < 1000; ++i ) {
+        ( gen() % 2 ? a : b ).insert( randomKey( gen, 10 ), i );
+    }
+    auto zip = []( int x, int y ) { return x - y; };
+    Trie< int > expected( a );
+    expected.uniteWith( b, zip );
+    a.uniteWith( std::move( b ), zip );
+    REQUIRE( dump( a ) == dump( expected ) );
+    REQUIRE( b.begin() == b.end() );
+    REQUIRE( b.stats().node_count == 1 );
+    b.insert( { true }, 1 );
+    REQUIRE( *b.search( { true } ) == 1 );
+}
+
+TEST_CASE( "uniteWith rvalue moves values" ) {
+    using Shared = std::shared_ptr< int >;
+    Trie< Shared > a, b;
+    Shared only = std::make_shared< int >( 1 ), both = std::make_shared< int >( 2 );
+    a.insert( { true }, std::make_shared< int >( 3 ) );
+    b.insert( { false, true }, only );
+    b.insert( { true }, both );
+    only.reset();
+    both.reset();
+    a.uniteWith( std::move( b ), []( const Shared& x, const Shared& y ) { return std::make_shared< int >( *x + *y ); } );
+    REQUIRE( a.search( { false, true } )->use_count() == 1 );    // moved, not copied
+    REQUIRE( **a.search( { false, true } ) == 1 );
+    REQUIRE( **a.search( { true } ) == 5 );
+
+    a.uniteWith( std::move( a ), []( const Shared& x, const Shared& ) { return x; } );
+    REQUIRE( **a.search( { true } ) == 5 );                     // self-union keeps the content
+    REQUIRE( a.search( { false, true } ) );
+}
+
+TEST_CASE( "stats of a small Trie" ) {
+    Trie< int > trie;
+    auto empty = trie.stats();
+    REQUIRE( empty.node_count == 1 );
+    REQUIRE( empty.value_count == 0 );
+    REQUIRE( empty.depth_histogram == std::vector< std::size_t >{ 1 } );
+    REQUIRE( empty.bytes == sizeof( Trie< int > ) );
+    REQUIRE( empty.average_lookup_depth == 0 );
+
+    //          root
+    //        0/    \1
+    //       (30)    o
+    //             0/ \1
+    //             o  (20)
+    //              \1
+    //              (10)
+    trie.insert( { true, false, true }, 10 );
+    trie.insert( { true, true }, 20 );
+    trie.insert( { false }, 30 );
+    auto stats = trie.stats();
+    REQUIRE( stats.node_count == 6 );
+    REQUIRE( stats.value_count == 3 );
+    REQUIRE( stats.single_child == 1 );
+    REQUIRE( stats.two_children == 2 );
+    std::vector< std::size_t > histogram{ 1, 2, 2, 1 };
+    REQUIRE( stats.depth_histogram == histogram );
+    REQUIRE( stats.average_lookup_depth == 2.0 );  // ( 1 + 2 + 3 ) / 3
+    if ( sizeof( void* ) == 8 ) {
+        // 24-byte Node and 4-byte int, each with 8-byte header rounded up to 16 bytes, 32 at least
+        REQUIRE( stats.bytes == sizeof( Trie< int > ) + 5 * 32 + 3 * 32 );
+    }
+
+    trie.remove( { true, false, true } );
+    stats = trie.stats();
+    REQUIRE( stats.node_count == 4 );
+    REQUIRE( stats.single_child == 1 );
+    REQUIRE( stats.two_children == 1 );
+    histogram = { 1, 2, 1 };
+    REQUIRE( stats.depth_histogram == histogram );
+    REQUIRE( stats.average_lookup_depth == 1.5 );
+}
@@ -1,13 +1,33 @@
 #ifndef TRIE_H
 #define TRIE_H
 
+#include <atomic>
+#include <exception>
+#include <iterator>
 #include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
 #include <vector>
 
-template<typename Value>
+#include "key_traits.h"
+
+template<typename Value, typename KeyTraits>
+class FrozenTrie;
+
+/**
+ *  Binary Trie:
+ *  		keys are sequences of bits read through KeyTraits (see key_traits.h),
+ *  		by default keys are std::vector<bool>
+ */
+template<typename Value, typename KeyTraits = BitSequenceTraits>
 class Trie {
-	using Seq = std::vector< bool >;
+	using Seq = typename KeyTraits::key_type;
 public:
+	using key_type = Seq;
+	using traits_type = KeyTraits;
+
 	/**
 	 * @brief	class representing inner node of Binary Trie
 	 */
@@ -44,6 +64,16 @@ public:
 		std::unique_ptr<Node> _right;
 	};
 
+	/**
+	 * @brief	prefix of a key which holds value
+	 * 			value		raw pointer to the value (nullptr if no prefix holds one)
+	 * 			length		number of bits of the prefix
+	 */
+	struct Match {
+		const Value* value;
+		std::size_t length;
+	};
+
 	/**
 	 * @brief default ctor
 	 */
@@ -54,7 +84,43 @@ public:
 	 * @param 	other		instance of Trie class
 	 */
 	Trie(const Trie& other) {
-		_copy(_root.get(), other._root.get());
+		try {
+			_copy(&_root, &other._root);
+		} catch (...) {
+			_clear();
+			throw;
+		}
+	}
+
+	/**
+	 * @brief	move ctor
+	 * 			takes over all Nodes, other is left empty
+	 * @param 	other		instance of Trie class
+	 */
+	Trie(Trie&& other) noexcept
+			: _root(std::move(other._root)) {}
+
+	/**
+	 * @brief	move assignment
+	 * 			takes over all Nodes, other is left empty
+	 * @param 	other		instance of Trie class
+	 * @return 	reference to this
+	 */
+	Trie& operator=(Trie&& other) noexcept {
+		if (this != &other) {
+			Node root = std::move(other._root);
+			_clear();
+			_root = std::move(root);
+		}
+		return *this;
+	}
+
+	/**
+	 * @brief	dtor
+	 * 			releases Nodes without recursion, so deep Tries cannot overflow the stack
+	 */
+	~Trie() {
+		_clear();
 	}
 
 	/**
@@ -63,20 +129,20 @@ public:
 	 * 			NOTE: root already exists
 	 */
 	const Node& root() const noexcept {
-		return *_root;
+		return _root;
 	}
 
 	/**
 	 * @brief	inserts element to the Trie
 	 * 			if element is already present in Trie insertion will not take a place
-	 * @param 	seq			sequence vector of booleans
+	 * @param 	seq			key
 	 * @param 	val			value to be inserted
 	 * @return	true if insertion succeeds, false otherwise
 	 */
 	bool insert(const Seq& seq, const Value& val) {
-		const Node* node = _root.get();
-		for (bool r : seq) {
-			if (r) {
+		const Node* node = &_root;
+		for (std::size_t i = 0, n = KeyTraits::size(seq); i < n; ++i) {
+			if (KeyTraits::bit(seq, i)) {
 				if (!node->right())
 					const_cast<Node*>(node)->_right = std::make_unique<Node>();
 				node = node->right();
@@ -92,9 +158,52 @@ public:
 		return true;
 	}
 
+	/**
+	 * @brief	replaces content of the Trie by elements of entries
+	 * 			bits of the previous key are kept next to the Nodes on its path,
+	 * 			every key is compared with them to find the shared prefix and
+	 * 			continues from the Node at its end without walking from the root,
+	 * 			for keys sorted by bits the whole build is linear
+	 * 			(ArenaTrie::build_from_sorted also allocates Nodes contiguously)
+	 * 			unsorted keys are inserted correctly, they only share less of the path
+	 * 			if a key repeats, its first value is kept
+	 * @param 	entries		range of (key, value) pairs sorted by keys
+	 * @return	number of inserted elements
+	 */
+	template< typename Entries >
+	std::size_t build_from_sorted(const Entries& entries) {
+		_clear();
+		std::vector<Node*> path{ &_root };
+		std::vector<bool> prev;
+		std::size_t inserted = 0;
+		for (const auto& [seq, val] : entries) {
+			std::size_t n = KeyTraits::size(seq), common = 0;
+			std::size_t shared = n < prev.size() ? n : prev.size();
+			while (common < shared && KeyTraits::bit(seq, common) == prev[common])
+				++common;
+			path.resize(common + 1);
+			prev.resize(n);
+			Node* node = path.back();
+			for (std::size_t i = common; i < n; ++i) {
+				bool r = KeyTraits::bit(seq, i);
+				prev[i] = r;
+				std::unique_ptr<Node>& slot = r ? node->_right : node->_left;
+				if (!slot)
+					slot = std::make_unique<Node>();
+				node = slot.get();
+				path.push_back(node);
+			}
+			if (!node->_value) {
+				node->_value = std::make_unique<Value>(val);
+				++inserted;
+			}
+		}
+		return inserted;
+	}
+
 	/**
 	 * @brief	searches for value
-	 * @param 	seq			sequence vector of booleans
+	 * @param 	seq			key
 	 * @return 	const raw pointer to the value, nullptr if value is not present
 	 */
 	const Value* search(const Seq& seq) const noexcept {
@@ -104,23 +213,132 @@ public:
 
 	/**
 	 * @brief	searches for value
-	 * @param 	seq			sequence vector of booleans
+	 * @param 	seq			key
 	 * @return 	raw pointer to the value, nullptr if value is not present
 	 */
 	Value* search(const Seq& seq) noexcept {
 		return const_cast<Value*>(const_cast<const Trie*>(this)->search(seq));
 	}
 
+	/**
+	 * @brief	searches for values of many keys
+	 * 			up to 32 lookups advance in lock-step, one level at a time,
+	 * 			the next Node of every lookup is prefetched before the others
+	 * 			take their step, so cache misses of different keys overlap
+	 * @param 	keys		random access range of keys
+	 * @param 	out			random access iterator, out[i] receives the result for keys[i]
+	 * 						(const raw pointer to the value, nullptr if value is not present)
+	 */
+	template< typename Keys, typename Out >
+	void search_batch(const Keys& keys, Out out) const noexcept {
+		constexpr std::size_t batch = 32;
+		const Node* nodes[batch];
+		std::size_t lengths[batch];
+		for (std::size_t first = 0, count = std::size(keys); first < count; first += batch) {
+			std::size_t n = count - first < batch ? count - first : batch;
+			for (std::size_t i = 0; i < n; ++i) {
+				nodes[i] = &_root;
+				lengths[i] = KeyTraits::size(keys[first + i]);
+			}
+			std::size_t active = n;
+			for (std::size_t depth = 0; active; ++depth) {
+				for (std::size_t i = 0; i < n; ++i) {
+					if (!nodes[i] || depth > lengths[i])
+						continue;
+					if (depth == lengths[i]) {
+						out[first + i] = nodes[i]->value();
+						--active;
+						continue;
+					}
+					const Node* next = KeyTraits::bit(keys[first + i], depth) ? nodes[i]->right() : nodes[i]->left();
+					if (!next) {
+						out[first + i] = nullptr;
+						--active;
+					} else {
+						_prefetch(next);
+					}
+					nodes[i] = next;
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief	finds the longest prefix of key which holds value
+	 * 			walks the key only once
+	 * @param 	seq			key
+	 * @return 	value of the deepest Node on the key's path and its depth
+	 */
+	Match longest_prefix_match(const Seq& seq) const noexcept {
+		const Node* node = &_root;
+		Match match{ node->value(), 0 };
+		for (std::size_t i = 0, n = KeyTraits::size(seq); i < n; ++i) {
+			node = KeyTraits::bit(seq, i) ? node->right() : node->left();
+			if (!node)
+				break;
+			if (node->value())
+				match = Match{ node->value(), i + 1 };
+		}
+		return match;
+	}
+
+	/**
+	 * @brief	finds all prefixes of key which hold value
+	 * @param 	seq			key
+	 * @return 	values on the key's path ordered from the shortest prefix
+	 */
+	std::vector<Match> all_prefixes(const Seq& seq) const {
+		std::vector<Match> matches;
+		const Node* node = &_root;
+		if (node->value())
+			matches.push_back(Match{ node->value(), 0 });
+		for (std::size_t i = 0, n = KeyTraits::size(seq); i < n; ++i) {
+			node = KeyTraits::bit(seq, i) ? node->right() : node->left();
+			if (!node)
+				break;
+			if (node->value())
+				matches.push_back(Match{ node->value(), i + 1 });
+		}
+		return matches;
+	}
+
 	/**
 	 * @brief	removes element
-	 * @param 	seq 		sequence vector of booleans
+	 * 			prunes only Nodes on the key's path which are left without value and children,
+	 * 			runs in O(key length)
+	 * @param 	seq 		key
+	 * @return 	true if element was present, false otherwise
 	 */
-	void remove(const Seq& seq) {
-		Node* node = const_cast<Node*>(_search(seq));
-		if (node) {
-			node->_value.reset();
-			_clear_leaves(_root.get());
+	bool remove(const Seq& seq) {
+		Node* node = &_root;
+		std::unique_ptr<Node>* cut = nullptr;     // topmost owner of the chain which becomes empty
+		for (std::size_t i = 0, n = KeyTraits::size(seq); i < n; ++i) {
+			std::unique_ptr<Node>& slot = KeyTraits::bit(seq, i) ? node->_right : node->_left;
+			if (!slot)
+				return false;
+			if (!cut || node->value() || (node->left() && node->right()))
+				cut = &slot;
+			node = slot.get();
 		}
+		if (!node->value())
+			return false;
+		node->_value.reset();
+		if (cut && !node->left() && !node->right())
+			_destroy(*cut);
+		return true;
+	}
+
+	/**
+	 * @brief	removes elements
+	 * @param 	keys 		range of keys
+	 * @return 	number of removed elements
+	 */
+	template< typename Keys >
+	std::size_t remove_all(const Keys& keys) {
+		std::size_t removed = 0;
+		for (const auto& seq : keys)
+			removed += remove(seq);
+		return removed;
 	}
 
 	/**
@@ -130,7 +348,42 @@ public:
 	 */
 	template< typename Zip >
 	void uniteWith(const Trie& other, Zip zip) {
-		_uniteWith(_root.get(), other._root.get(), zip);
+		_uniteWith(&_root, &other._root, zip);
+	}
+
+	/**
+	 * @brief	unites two Tries, takes Nodes and values from other
+	 * 			subtrees missing in this Trie are moved over as a whole,
+	 * 			values are moved instead of copied, other is left empty
+	 * @param 	other 		other Trie
+	 * @param 	zip 		function objects to zip values
+	 */
+	template< typename Zip >
+	void uniteWith(Trie&& other, Zip zip) {
+		if (this == &other) {
+			uniteWith(static_cast<const Trie&>(other), zip);
+			return;
+		}
+		std::vector<std::pair<Node*, Node*>> stack{ { &_root, &other._root } };
+		while (!stack.empty()) {
+			auto [dst, src] = stack.back();
+			stack.pop_back();
+			if (src->_value) {
+				if (dst->_value)
+					*dst->_value = zip(*dst->value(), std::move(*src->_value));
+				else
+					dst->_value = std::move(src->_value);
+			}
+			if (!dst->_left)
+				dst->_left = std::move(src->_left);
+			else if (src->_left)
+				stack.emplace_back(dst->_left.get(), src->_left.get());
+			if (!dst->_right)
+				dst->_right = std::move(src->_right);
+			else if (src->_right)
+				stack.emplace_back(dst->_right.get(), src->_right.get());
+		}
+		other._clear();
 	}
 
 	/**
@@ -140,12 +393,308 @@ public:
 	 */
 	template< typename Zip >
 	void intersectWith(const Trie& other, Zip zip) {
-		_intersectWith(_root.get(), other._root.get(), zip);
-		_clear_leaves(_root.get());
+		_intersectWith(&_root, &other._root, zip);
+	}
+
+	/**
+	 * @brief	unites two Tries on several threads
+	 * 			top levels are merged sequentially until there are enough independent
+	 * 			pairs of subtrees, which are then merged by worker threads
+	 * 			other Trie of fewer than _parallel_threshold Nodes is merged sequentially
+	 * @param 	other 		other Trie
+	 * @param 	zip 		function objects to zip values, every worker uses its own copy
+	 * @param 	threads		number of worker threads (1 merges sequentially)
+	 */
+	template< typename Zip >
+	void parallelUniteWith(const Trie& other, Zip zip, unsigned threads = std::thread::hardware_concurrency()) {
+		if (threads <= 1 || !_is_large(&other._root)) {
+			_uniteWith(&_root, &other._root, zip);
+			return;
+		}
+		std::vector<NodePair> upper;
+		std::vector<NodePair> tasks = _split(other, threads, upper, [&zip](Node* dst, const Node* src, auto push) {
+			_uniteStep(dst, src, zip, push);
+		});
+		_run_parallel(tasks, threads, [zip](Node* dst, const Node* src) mutable {
+			_uniteWith(dst, src, zip);
+		});
+	}
+
+	/**
+	 * @brief	intersects two Tries on several threads
+	 * 			top levels are intersected sequentially until there are enough independent
+	 * 			pairs of subtrees, which are then intersected by worker threads
+	 * 			Tries of fewer than _parallel_threshold Nodes are intersected sequentially
+	 * @param 	other		other Trie
+	 * @param 	zip 		function object to zip values, every worker uses its own copy
+	 * @param 	threads		number of worker threads (1 intersects sequentially)
+	 */
+	template< typename Zip >
+	void parallelIntersectWith(const Trie& other, Zip zip, unsigned threads = std::thread::hardware_concurrency()) {
+		if (threads <= 1 || !_is_large(&_root) || !_is_large(&other._root)) {
+			_intersectWith(&_root, &other._root, zip);
+			return;
+		}
+		std::vector<NodePair> upper;
+		std::vector<NodePair> tasks = _split(other, threads, upper, [&zip](Node* dst, const Node* src, auto push) {
+			_intersectStep(dst, src, zip, push);
+		});
+		_run_parallel(tasks, threads, [zip](Node* dst, const Node* src) mutable {
+			_intersectWith(dst, src, zip);
+		});
+		for (auto it = upper.rbegin(); it != upper.rend(); ++it)
+			_prune_children(it->first);
+	}
+
+	/**
+	 * @brief	shape and memory statistics returned by stats()
+	 * 			node_count				number of Nodes (including the root)
+	 * 			value_count				number of Nodes holding value
+	 * 			single_child			number of Nodes with exactly one child
+	 * 			two_children			number of Nodes with both children
+	 * 			depth_histogram			number of Nodes at every depth, index is the depth
+	 * 			bytes					memory of Nodes and values including allocator overhead
+	 * 									(estimated for malloc with 16-byte granularity and
+	 * 									one word of header, memory owned by values is not counted)
+	 * 			average_lookup_depth	average depth of Nodes holding value
+	 */
+	struct Stats {
+		std::size_t node_count = 0;
+		std::size_t value_count = 0;
+		std::size_t single_child = 0;
+		std::size_t two_children = 0;
+		std::vector<std::size_t> depth_histogram;
+		std::size_t bytes = 0;
+		double average_lookup_depth = 0;
+	};
+
+	/**
+	 * @brief	walks the whole Trie and collects its statistics
+	 * @return 	Stats of the Trie
+	 */
+	Stats stats() const {
+		Stats stats;
+		std::size_t depth_sum = 0;
+		std::vector<std::pair<const Node*, std::size_t>> stack{ { &_root, 0 } };
+		while (!stack.empty()) {
+			auto [node, depth] = stack.back();
+			stack.pop_back();
+			++stats.node_count;
+			if (stats.depth_histogram.size() <= depth)
+				stats.depth_histogram.resize(depth + 1);
+			++stats.depth_histogram[depth];
+			if (node->value()) {
+				++stats.value_count;
+				depth_sum += depth;
+			}
+			int children = bool(node->left()) + bool(node->right());
+			stats.single_child += children == 1;
+			stats.two_children += children == 2;
+			if (node->right())
+				stack.emplace_back(node->right(), depth + 1);
+			if (node->left())
+				stack.emplace_back(node->left(), depth + 1);
+		}
+		stats.bytes = sizeof(Trie) + (stats.node_count - 1) * _allocation_size(sizeof(Node))
+				+ stats.value_count * _allocation_size(sizeof(Value));
+		if (stats.value_count)
+			stats.average_lookup_depth = double(depth_sum) / stats.value_count;
+		return stats;
+	}
+
+	/**
+	 * @brief	creates immutable succinct copy of the Trie (see frozen_trie.h)
+	 * @return 	FrozenTrie with the same elements
+	 */
+	FrozenTrie<Value, KeyTraits> freeze() const {
+		return FrozenTrie<Value, KeyTraits>(*this);
+	}
+
+	/**
+	 * @brief	element visited by const_iterator
+	 * 			key			bits on the path from the root
+	 * 			value		stored value
+	 */
+	struct Entry {
+		const std::vector<bool>& key;
+		const Value& value;
+	};
+
+	/**
+	 * 	forward iterator visiting elements in lexicographic order of keys
+	 * 		(prefix precedes its extensions, 0 precedes 1)
+	 * 		traverses the Trie with an explicit stack instead of recursion
+	 */
+	class const_iterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = Entry;
+		using difference_type = std::ptrdiff_t;
+		using reference = Entry;
+		using pointer = void;
+
+		/**
+		 * @brief	constructs end iterator
+		 */
+		const_iterator() = default;
+
+		/**
+		 * @return 	key and value of the current element
+		 */
+		Entry operator*() const {
+			return Entry{ _key, *_stack.back().node->value() };
+		}
+
+		/**
+		 * @return 	bits of the current key
+		 */
+		const std::vector<bool>& key() const noexcept {
+			return _key;
+		}
+
+		/**
+		 * @return 	current value
+		 */
+		const Value& value() const noexcept {
+			return *_stack.back().node->value();
+		}
+
+		const_iterator& operator++() {
+			_advance();
+			return *this;
+		}
+
+		const_iterator operator++(int) {
+			const_iterator tmp = *this;
+			_advance();
+			return tmp;
+		}
+
+		bool operator==(const const_iterator& it) const noexcept {
+			if (_stack.empty() || it._stack.empty())
+				return _stack.empty() == it._stack.empty();
+			return _stack.back().node == it._stack.back().node;
+		}
+		bool operator!=(const const_iterator& it) const noexcept {
+			return !(*this == it);
+		}
+
+	private:
+		friend class Trie;
+
+		/**
+		 * 	Node waiting to be visited, the top of the stack is the current Node
+		 */
+		struct Frame {
+			const Node* node;
+			std::size_t depth;
+			bool bit;
+		};
+
+		std::vector<Frame> _stack;
+		std::vector<bool> _key;
+
+		/**
+		 * @brief	starts traversal of the subtree
+		 * @param 	node		root of the subtree (nullptr for empty range)
+		 * @param 	prefix		key of the node
+		 */
+		const_iterator(const Node* node, std::vector<bool> prefix)
+				: _key(std::move(prefix)) {
+			if (!node)
+				return;
+			_stack.push_back(Frame{ node, _key.size(), false });
+			if (!node->value())
+				_advance();
+		}
+
+		/**
+		 * @brief	moves to the next Node holding value in pre-order
+		 */
+		void _advance() {
+			do {
+				Frame top = _stack.back();
+				_stack.pop_back();
+				if (top.node->right())
+					_stack.push_back(Frame{ top.node->right(), top.depth + 1, true });
+				if (top.node->left())
+					_stack.push_back(Frame{ top.node->left(), top.depth + 1, false });
+				if (_stack.empty())
+					return;
+				const Frame& next = _stack.back();
+				_key.resize(next.depth);
+				_key.back() = next.bit;
+			} while (!_stack.back().node->value());
+		}
+	};
+
+	/**
+	 * 	pair of iterators returned by prefix_range
+	 */
+	struct Range {
+		const_iterator first;
+		const_iterator last;
+
+		const_iterator begin() const {
+			return first;
+		}
+		const_iterator end() const {
+			return last;
+		}
+	};
+
+	/**
+	 * @return 	iterator to the element with the smallest key
+	 */
+	const_iterator begin() const {
+		return const_iterator(&_root, {});
+	}
+
+	/**
+	 * @return 	end iterator
+	 */
+	const_iterator end() const {
+		return const_iterator();
+	}
+
+	/**
+	 * @brief	elements whose keys start with prefix
+	 * @param 	prefix		key prefix
+	 * @return 	range of iterators over the subtree of prefix
+	 */
+	Range prefix_range(const Seq& prefix) const {
+		std::vector<bool> key(KeyTraits::size(prefix));
+		for (std::size_t i = 0; i < key.size(); ++i)
+			key[i] = KeyTraits::bit(prefix, i);
+		return Range{ const_iterator(_search(prefix), std::move(key)), const_iterator() };
+	}
+
+	/**
+	 * @brief	calls f on every value in key order
+	 * 			does not build keys
+	 * @param 	f			function object taking const Value&
+	 */
+	template< typename F >
+	void for_each(F f) const {
+		std::vector<const Node*> stack{ &_root };
+		while (!stack.empty()) {
+			const Node* node = stack.back();
+			stack.pop_back();
+			if (node->value())
+				f(*node->value());
+			if (node->right())
+				stack.push_back(node->right());
+			if (node->left())
+				stack.push_back(node->left());
+		}
 	}
 
 private:
-	std::unique_ptr<Node> _root = std::make_unique<Node>();
+	using NodePair = std::pair<Node*, const Node*>;
+
+	static constexpr std::size_t _parallel_threshold = 1 << 14;   // Nodes, smaller Tries are merged sequentially
+
+	Node _root;                 // root is part of the Trie, so moving the Trie allocates nothing
 
 	/**
 	 * @brief	copies Nodes from one Trie to another
@@ -154,27 +703,61 @@ private:
 	 * @param 	from 		Node from which is being copied
 	 */
 	void _copy(Node* to, const Node* from) {
-		if (from->value())
-			to->_value = std::make_unique<Value>(*from->value());
-		if (from->left()) {
-			to->_left = std::make_unique<Node>();
-			_copy(const_cast<Node*>(to->left()), from->left());
+		std::vector<NodePair> stack{ { to, from } };
+		while (!stack.empty()) {
+			auto [dst, src] = stack.back();
+			stack.pop_back();
+			if (src->value())
+				dst->_value = std::make_unique<Value>(*src->value());
+			if (src->left()) {
+				dst->_left = std::make_unique<Node>();
+				stack.emplace_back(dst->_left.get(), src->left());
+			}
+			if (src->right()) {
+				dst->_right = std::make_unique<Node>();
+				stack.emplace_back(dst->_right.get(), src->right());
+			}
 		}
-		if (from->right()) {
-			to->_right = std::make_unique<Node>();
-			_copy(const_cast<Node*>(to->right()), from->right());
+	}
+
+	/**
+	 * @brief	removes all Nodes below the root and the root's value
+	 */
+	void _clear() noexcept {
+		_destroy(_root._left);
+		_destroy(_root._right);
+		_root._value.reset();
+	}
+
+	/**
+	 * @brief	destroys subtree without recursion and without allocation
+	 * 			left children are rotated to the right until the Node has none,
+	 * 			then the Node is deleted and its right child is processed
+	 * @param 	slot		owner of the subtree, empty afterwards
+	 */
+	static void _destroy(std::unique_ptr<Node>& slot) noexcept {
+		std::unique_ptr<Node> node = std::move(slot);
+		while (node) {
+			if (node->_left) {
+				std::unique_ptr<Node> left = std::move(node->_left);
+				node->_left = std::move(left->_right);
+				left->_right = std::move(node);
+				node = std::move(left);
+			} else {
+				node = std::move(node->_right);     // Node without children is deleted
+			}
 		}
 	}
 
 	/**
 	 * @brief	searches for Node at provided Sequence
-	 * @param 	seq			sequence vector of booleans
+	 * @param 	seq			key
 	 * @return	raw pointer to Node if Node is present, nullptr otherwise
 	 */
 	const Node* _search(const Seq& seq) const noexcept {
-		const Node* node = _root.get();
-		for (bool r : seq) {
-			if (r) {
+		const Node* node = &_root;
+		for (std::size_t i = 0, n = KeyTraits::size(seq); i < n; ++i) {
+			if (KeyTraits::bit(seq, i)) {
 				if (!node->right())
 					return nullptr;
 				node = node->right();
@@ -187,89 +770,246 @@ private:
 		return node;
 	}
 
+	/**
+	 * @return	estimated size of heap block holding n bytes
+	 */
+	static constexpr std::size_t _allocation_size(std::size_t n) noexcept {
+		std::size_t size = (n + sizeof(void*) + 15) & ~std::size_t(15);
+		return size < 32 ? 32 : size;
+	}
+
+	static void _prefetch(const void* address) noexcept {
+#if defined( __GNUC__ )
+		__builtin_prefetch(address);
+#else
+		(void)address;
+#endif
+	}
+
 	/**
 	 * @brief	checks whether node is leaf or not
 	 * 			(leaf = no value && no children)
 	 * @param 	node
 	 * @return 	true if node is leaf, false otherwise
 	 */
-	bool _is_leaf(const Node* node) const noexcept {
+	static bool _is_leaf(const Node* node) noexcept {
 		return !node->value() && !node->left() && !node->right();
 	}
 
 	/**
-	 * @brief	clears leaves from Node
-	 * @param 	node
+	 * @brief	merges values of one pair of Nodes and creates missing children
+	 * @param 	dst 		Node of Trie which will be result of union
+	 * @param 	src 		Node of Trie with which Trie is being united
+	 * @param 	zip			zipping function
+	 * @param 	push		called with pairs of children which have to be merged next
 	 */
-	void _clear_leaves(const Node* node) noexcept {
-		if (node->left()) {
-			_clear_leaves(node->left());
-			if (_is_leaf(node->left()))
-				const_cast<Node*>(node)->_left.reset();
+	template <typename Zip, typename Push>
+	static void _uniteStep(Node* dst, const Node* src, Zip& zip, Push push) {
+		if (src->value()) {
+			if (dst->value()) {
+				*dst->_value = zip(*dst->value(), *src->value());
+			} else {
+				dst->_value = std::make_unique<Value>(*src->value());
+			}
 		}
+		if (src->left()) {
+			if (!dst->left())
+				dst->_left = std::make_unique<Node>();
+			push(dst->_left.get(), src->left());
+		}
+		if (src->right()) {
+			if (!dst->right())
+				dst->_right = std::make_unique<Node>();
+			push(dst->_right.get(), src->right());
+		}
+	}
 
-		if (node->right()) {
-			_clear_leaves(node->right());
-			if (_is_leaf(node->right()))
-				const_cast<Node*>(node)->_right.reset();
+	/**
+	 * @brief	intersects values of one pair of Nodes and drops children missing in src
+	 * @param 	dst 		Node of Trie which will be result of intersect
+	 * @param 	src 		Node of Trie with which Trie is being intersected
+	 * @param 	zip			zipping function
+	 * @param 	push		called with pairs of children which have to be intersected next
+	 */
+	template <typename Zip, typename Push>
+	static void _intersectStep(Node* dst, const Node* src, Zip& zip, Push push) {
+		if (src->value()) {
+			if (dst->value()) {
+				*dst->_value = zip(*dst->value(), *src->value());
+			} else {
+				dst->_value.reset();
+			}
 		}
+		if (!src->left())
+			_destroy(dst->_left);
+		else if (dst->left())
+			push(dst->_left.get(), src->left());
+		if (!src->right())
+			_destroy(dst->_right);
+		else if (dst->right())
+			push(dst->_right.get(), src->right());
 	}
 
 	/**
-	 * @brief	recursive function used in uniteWith
+	 * @brief	removes children which are left as leaves
+	 * @param 	node
+	 */
+	static void _prune_children(Node* node) noexcept {
+		if (node->left() && _is_leaf(node->left()))
+			node->_left.reset();
+		if (node->right() && _is_leaf(node->right()))
+			node->_right.reset();
+	}
+
+	/**
+	 * @brief	function used in uniteWith
+	 * 			walks both Tries with an explicit stack
 	 * @param 	to 			raw pointer to the Node of Trie which will be result of union
 	 * @param 	with 		raw pointer to the Node of Trie with which Trie is being united
 	 * @param 	zip			zipping function
 	 */
 	template <typename Zip>
-	void _uniteWith(Node* to, const Node* with, Zip zip) {
-		if (with->value()) {
-			if (to->value()) {
-				*to->_value = zip(*to->value(), *with->value());
-			} else {
-				to->_value = std::make_unique<Value>(*with->value());
-			}
-		}
-		if (with->left()) {
-			if (!to->left())
-				to->_left = std::make_unique<Node>();
-			_uniteWith(const_cast<Node*>(to->left()), with->left(), zip);
-		}
-		if (with->right()) {
-			if (!to->right())
-				to->_right = std::make_unique<Node>();
-			_uniteWith(const_cast<Node*>(to->right()), with->right(), zip);
+	static void _uniteWith(Node* to, const Node* with, Zip& zip) {
+		std::vector<NodePair> stack{ { to, with } };
+		while (!stack.empty()) {
+			auto [dst, src] = stack.back();
+			stack.pop_back();
+			_uniteStep(dst, src, zip, [&stack](Node* d, const Node* s) {
+				stack.emplace_back(d, s);
+			});
 		}
 	}
 
 	/**
-	 * @brief	recursive function used by intersectWith
+	 * @brief	function used by intersectWith
+	 * 			walks both Tries with an explicit stack, every Node is visited twice:
+	 * 			values are zipped on the way down and children which are left
+	 * 			as leaves are pruned on the way up
 	 * @param 	to 			raw pointer to the Node of Trie which will be result of intersect
 	 * @param 	with 		raw pointer to the Node of Trie with which Trie is being intersected
 	 * @param 	zip			zipping function
 	 */
 	template <typename Zip>
-	void _intersectWith(Node* to, const Node* with, Zip zip) {
-		if (with->value()) {
-			if (to->value()) {
-				*to->_value = zip(*to->value(), *with->value());
-			} else {
-				to->_value.reset();
+	static void _intersectWith(Node* to, const Node* with, Zip& zip) {
+		struct Frame {
+			Node* to;
+			const Node* with;
+			bool visited;
+		};
+		std::vector<Frame> stack{ { to, with, false } };
+		while (!stack.empty()) {
+			Frame& frame = stack.back();
+			if (frame.visited) {
+				_prune_children(frame.to);
+				stack.pop_back();
+				continue;
 			}
+			frame.visited = true;
+			_intersectStep(frame.to, frame.with, zip, [&stack](Node* d, const Node* s) {
+				stack.push_back(Frame{ d, s, false });
+			});
 		}
-		if (!with->left()) {
-			if (to->left())
-				to->_left.reset();
-		} else {
-			_intersectWith(const_cast<Node*>(to->left()), with->left(), zip);
+	}
+
+	/**
+	 * @brief	counts Nodes of the subtree, stops at _parallel_threshold
+	 * @return	true if the subtree has at least _parallel_threshold Nodes
+	 */
+	static bool _is_large(const Node* node) {
+		std::vector<const Node*> stack{ node };
+		std::size_t count = 0;
+		while (!stack.empty() && count < _parallel_threshold) {
+			node = stack.back();
+			stack.pop_back();
+			++count;
+			if (node->left())
+				stack.push_back(node->left());
+			if (node->right())
+				stack.push_back(node->right());
 		}
-		if (!with->right()) {
-			if (to->right())
-				to->_right.reset();
-		} else {
-			_intersectWith(const_cast<Node*>(to->right()), with->right(), zip);
+		return count >= _parallel_threshold;
+	}
+
+	/**
+	 * @brief	walks both Tries level by level until there are enough pairs of subtrees
+	 * 			for threads workers
+	 * @param 	other		other Trie
+	 * @param 	threads		number of workers
+	 * @param 	upper		visited pairs in level order (output)
+	 * @param 	step		processes one pair and pushes pairs of its children
+	 * @return 	pairs of Nodes at the first level which is not visited
+	 */
+	template <typename Step>
+	std::vector<NodePair> _split(const Trie& other, unsigned threads, std::vector<NodePair>& upper, Step step) {
+		std::vector<NodePair> level{ { &_root, &other._root } };
+		std::size_t wanted = threads > 1 ? 8 * std::size_t(threads) : 1;
+		while (!level.empty() && level.size() < wanted) {
+			std::vector<NodePair> next;
+			for (auto [dst, src] : level) {
+				step(dst, src, [&next](Node* d, const Node* s) {
+					next.emplace_back(d, s);
+				});
+			}
+			upper.insert(upper.end(), level.begin(), level.end());
+			level.swap(next);
 		}
+		return level;
+	}
+
+	/**
+	 * @brief	calls merge on every pair of tasks from threads workers
+	 * 			the calling thread is one of them and takes over the tasks
+	 * 			of workers which could not be started,
+	 * 			the first exception thrown by merge is rethrown once all workers finish
+	 * @param 	tasks		pairs of Nodes of independent subtrees
+	 * @param 	threads		number of workers
+	 * @param 	merge		copied to every worker
+	 */
+	template <typename Merge>
+	static void _run_parallel(const std::vector<NodePair>& tasks, unsigned threads, Merge merge) {
+		std::atomic<std::size_t> next{ 0 };
+		std::exception_ptr error;
+		std::mutex error_mutex;
+		auto work = [&](Merge merge) {
+			try {
+				for (std::size_t i; (i = next++) < tasks.size();)
+					merge(tasks[i].first, tasks[i].second);
+			} catch (...) {
+				std::lock_guard<std::mutex> lock(error_mutex);
+				if (!error)
+					error = std::current_exception();
+				next = tasks.size();
+			}
+		};
+		{
+			std::vector<std::thread> workers;
+			struct Joiner {
+				std::vector<std::thread>& workers;
+				std::atomic<std::size_t>& next;
+				std::size_t end;
+
+				~Joiner() {
+					next = end;         // started workers stop after their current task if unwinding
+					for (auto& worker : workers)
+						worker.join();
+				}
+			} joiner{ workers, next, tasks.size() };
+			std::size_t count = threads < tasks.size() ? threads : tasks.size();
+			workers.reserve(count);
+			for (std::size_t i = 1; i < count; ++i) {
+				try {
+					workers.emplace_back(work, merge);
+				} catch (const std::system_error&) {
+					break;
+				}
+			}
+			work(merge);
+		}
+		if (error)
+			std::rethrow_exception(error);
 	}
 };
 
+#include "frozen_trie.h"
+
 #endif